@@ -0,0 +1,263 @@
+#!/usr/bin/env python
+"""
+Performance regression tests of FASST.
+
+The pipeline cases generate a synthetic mixture with fasst-synth, then run
+model-estimation and source-estimation on it. Their time and peak memory, the
+log-likelihood of each iteration and the SNR of the separated sources are
+compared with baseline.json. The kernel cases run microbenchmarks and compare
+their throughput.
+
+The numeric outputs do not depend on the machine, while the times, the peak
+memory and the throughputs are recorded by running with --update on the
+reference machine described in the baseline. After a change which is expected
+to modify the numeric outputs, record them again with --update-outputs. A value
+which is null in the baseline is only reported, unless --ci is given: it is
+then a failure, so that a baseline which was never recorded can not pass.
+"""
+
+from __future__ import division, print_function
+import argparse
+import array
+import collections
+import itertools
+import json
+import math
+import os
+import struct
+import subprocess
+import sys
+import time
+
+
+TIME_UNITS = {'ns': 1e9, 'us': 1e6, 'ms': 1e3, 's': 1.}
+
+
+def executable(bindir, name):
+    if os.name == 'nt':
+        name += '.exe'
+    return os.path.join(bindir, name)
+
+
+def run(args, profile=None):
+    """Runs a program and returns its elapsed time in seconds"""
+    env = dict(os.environ)
+    if profile:
+        env['FASST_PROFILE'] = profile
+    start = time.time()
+    with open(os.devnull, 'w') as devnull:
+        subprocess.check_call(args, stdout=devnull, env=env)
+    return time.time() - start
+
+
+def read_profile(fname):
+    """Returns the log-likelihoods and the summary of a FASST_PROFILE file"""
+    log_like = []
+    summary = None
+    with open(fname) as f:
+        for line in f:
+            obj = json.loads(line)
+            if 'iteration' in obj:
+                log_like.append(obj['log_likelihood'])
+            else:
+                summary = obj['summary']
+    return log_like, summary
+
+
+def read_wav(fname):
+    """Returns the channels of a 16-bit or float WAV file"""
+    with open(fname, 'rb') as f:
+        data = f.read()
+    if data[0:4] != b'RIFF' or data[8:12] != b'WAVE':
+        raise RuntimeError(fname + ' is not a WAV file')
+    pos = 12
+    fmt = None
+    while pos + 8 <= len(data):
+        chunk, size = struct.unpack('<4sI', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + size]
+        if chunk == b'fmt ':
+            fmt = struct.unpack('<HHIIHH', body[0:16])
+        elif chunk == b'data':
+            break
+        pos += 8 + size + (size & 1)
+    channels, bits = fmt[1], fmt[5]
+    if bits == 32:
+        samples = array.array('f')
+    elif bits == 16:
+        samples = array.array('h')
+    else:
+        raise RuntimeError(fname + ' has an unsupported sample format')
+    if hasattr(samples, 'frombytes'):
+        samples.frombytes(body)
+    else:
+        samples.fromstring(body)
+    if sys.byteorder != 'little':
+        samples.byteswap()
+    scale = 1. if bits == 32 else 1. / 32768
+    return [[x * scale for x in samples[i::channels]]
+            for i in range(channels)]
+
+
+def snr(reference, estimate):
+    """Returns the SNR in dB of the estimate of a multichannel signal"""
+    signal = 0.
+    noise = 0.
+    for r, e in zip(reference, estimate):
+        for a, b in zip(r, e):
+            signal += a * a
+            noise += (a - b) * (a - b)
+    return 10 * math.log10(signal / max(noise, 1e-30))
+
+
+def mean_snr(references, estimates):
+    """Returns the mean SNR over the sources, for the best permutation of
+    the estimates"""
+    J = len(references)
+    table = [[snr(references[j], estimates[k]) for k in range(J)]
+             for j in range(J)]
+    return max(sum(table[j][p[j]] for j in range(J)) / J
+               for p in itertools.permutations(range(J)))
+
+
+class Checker(object):
+    def __init__(self, tolerance, update, update_outputs, ci):
+        self.tolerance = tolerance
+        self.update = update
+        self.update_outputs = update_outputs
+        self.ci = ci
+        self.failures = 0
+
+    def check(self, case, key, value, better):
+        """Compares a measured value with the baseline. better is 'lower' or
+        'higher' for performance values, 'equal' for numeric outputs."""
+        reference = case.get(key)
+        update = self.update_outputs if better == 'equal' else self.update
+        if update or (reference is None and not self.ci):
+            status = 'recorded' if self.update or self.update_outputs \
+                else 'not in baseline'
+            case[key] = value
+        elif reference is None:
+            status = 'MISSING'
+        elif better == 'equal' and isinstance(value, list):
+            # Relative tolerance, for the log-likelihoods
+            tol = self.tolerance[key]
+            ok = len(value) == len(reference) and \
+                all(abs(a - b) <= tol * max(1., abs(b))
+                    for a, b in zip(value, reference))
+            status = 'ok' if ok else 'CHANGED'
+        elif better == 'equal':
+            ok = abs(value - reference) <= self.tolerance[key]
+            status = 'ok' if ok else 'CHANGED'
+        else:
+            tol = self.tolerance[key]
+            if better == 'lower':
+                ok = value <= reference * (1 + tol)
+            else:
+                ok = value >= reference * (1 - tol)
+            status = 'ok' if ok else 'REGRESSION'
+        if status in ('CHANGED', 'REGRESSION', 'MISSING'):
+            self.failures += 1
+        shown = '%d values' % len(value) if isinstance(value, list) else \
+            '%.6g' % value
+        print('%-36s %-20s %-16s %s' % (case['name'], key, shown, status))
+
+
+def pipeline(args, baseline, checker):
+    synth = executable(args.bin, 'fasst-synth')
+    estimation = executable(args.bin, 'model-estimation')
+    separation = executable(args.bin, 'source-estimation')
+    for case in baseline['pipeline']:
+        work = os.path.join(args.work, case['name'])
+        if not os.path.isdir(os.path.join(work, 'out')):
+            os.makedirs(os.path.join(work, 'out'))
+        run([synth, work] + case['synth'])
+
+        # Fix the number of iterations
+        xml = os.path.join(work, 'sources.xml')
+        with open(xml) as f:
+            content = f.read()
+        with open(xml, 'w') as f:
+            f.write(content.replace(
+                '<sources>',
+                '<sources>\n<iterations>%d</iterations>' % case['iterations'],
+                1))
+
+        profile = os.path.join(work, 'estimation.json')
+        seconds = run([estimation, xml, os.path.join(work, 'Rx.bin'),
+                       os.path.join(work, 'estimated.xml')], profile)
+        log_like, summary = read_profile(profile)
+        peak = summary['peak_rss_kb']
+
+        profile = os.path.join(work, 'separation.json')
+        separation_seconds = run(
+            [separation, os.path.join(work, 'mix.wav'),
+             os.path.join(work, 'estimated.xml'),
+             os.path.join(work, 'out'), 'float'], profile)
+        peak = max(peak, read_profile(profile)[1]['peak_rss_kb'])
+
+        J = int(case['synth'][3])
+        references = [read_wav(os.path.join(work, 'ref%d.wav' % j))
+                      for j in range(J)]
+        estimates = [read_wav(os.path.join(work, 'out', 'y%d.wav' % j))
+                     for j in range(J)]
+
+        checker.check(case, 'estimation_seconds', seconds, 'lower')
+        checker.check(case, 'separation_seconds', separation_seconds, 'lower')
+        checker.check(case, 'peak_rss_kb', peak, 'lower')
+        checker.check(case, 'log_likelihood', log_like, 'equal')
+        checker.check(case, 'snr_db', mean_snr(references, estimates), 'equal')
+
+
+def kernels(args, baseline, checker):
+    for case in baseline['kernels']:
+        output = subprocess.check_output(
+            [executable(args.bin, case['benchmark'] + '_bench'),
+             '--benchmark_filter=^' + case['name'] + '$',
+             '--benchmark_format=json'])
+        result = json.loads(output.decode('utf-8'))['benchmarks'][0]
+        if 'items_per_second' in result:
+            value = result['items_per_second']
+        else:
+            # One item per iteration for the benchmarks which don't count them
+            value = TIME_UNITS[result['time_unit']] / result['real_time']
+        checker.check(case, 'items_per_second', value, 'higher')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('--bin', required=True,
+                        help='the directory of the FASST executables')
+    parser.add_argument('--work', required=True,
+                        help='the directory of the generated files')
+    parser.add_argument('--baseline', required=True,
+                        help='the baseline JSON file')
+    parser.add_argument('--update', action='store_true',
+                        help='record the measured times, memory and '
+                        'throughputs in the baseline')
+    parser.add_argument('--update-outputs', action='store_true',
+                        help='record the measured numeric outputs in the '
+                        'baseline')
+    parser.add_argument('--ci', action='store_true',
+                        help='fail on the values which are null in the '
+                        'baseline instead of only reporting them')
+    parser.add_argument('cases', choices=['pipeline', 'kernels'])
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f, object_pairs_hook=collections.OrderedDict)
+    checker = Checker(baseline['tolerance'], args.update, args.update_outputs,
+                      args.ci)
+    if args.cases == 'pipeline':
+        pipeline(args, baseline, checker)
+    else:
+        kernels(args, baseline, checker)
+
+    if args.update or args.update_outputs:
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2, separators=(',', ': '))
+            f.write('\n')
+    return 1 if checker.failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
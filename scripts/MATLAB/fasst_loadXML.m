@@ -12,6 +12,11 @@ if ~isempty(domnode.getElementsByTagName('iterations').item(0))
     data.iterations = str2num(domnode.getElementsByTagName('iterations').item(0).getTextContent);
 end
 
+% Read minibatch_frames
+if ~isempty(domnode.getElementsByTagName('minibatch_frames').item(0))
+    data.minibatch_frames = str2num(domnode.getElementsByTagName('minibatch_frames').item(0).getTextContent);
+end
+
 % Read tfr_type
 if ~isempty(domnode.getElementsByTagName('tfr_type').item(0))
     data.tfr_type = char(domnode.getElementsByTagName('tfr_type').item(0).getTextContent);
@@ -8,6 +8,13 @@ if isfield(data, 'iterations')
     root.getDocumentElement.appendChild(iterationsNode);
 end
 
+% Generate minibatch_frames element
+if isfield(data, 'minibatch_frames')
+    minibatchNode = root.createElement('minibatch_frames');
+    minibatchNode.setTextContent(sprintf('%d', data.minibatch_frames));
+    root.getDocumentElement.appendChild(minibatchNode);
+end
+
 % Generate tfr element
 if isfield(data, 'tfr_type')
     tfr_typeNode = root.createElement('tfr_type');
@@ -1,32 +1,65 @@
 #include "fasst/Audio.h"
 #include "fasst/XMLDoc.h"
 #include "fasst/MixCovMatrix.h"
+#include "fasst/Batch.h"
 #include <iostream>
+#include <cstdlib>
+#include <stdexcept>
 
 using namespace std;
 
-int main(int argc, char *argv[]) {
-  // Read command line args
-  if (argc != 4) {
-    cout << "Usage:\t" << argv[0]
-         << " input-wav-file input-xml-file output-bin-file\n";
-    return 1;
-  }
-
-  // Read audio
-  fasst::Audio x(argv[1]);
-
+// Computes Rx while reading audio, and exports it
+static int computeRx(fasst::AudioReader &reader, const vector<string> &args) {
   // Read TFR parameters from XML
-  fasst::XMLDoc doc(argv[2]);
+  fasst::XMLDoc doc(args[1].c_str());
   std::string tfr_type = doc.getTFRType();
   int wlen = doc.getWlen();
   int nbin = doc.getNbin();
 
-  // Compute Rx
-  fasst::MixCovMatrix Rx(x, tfr_type, wlen, nbin);
+  // Compute Rx while reading audio
+  fasst::MixCovMatrix Rx(reader, tfr_type, wlen, nbin);
 
   // Export Rx
-  Rx.write(argv[3]);
+  Rx.write(args[2].c_str());
 
   return 0;
 }
+
+static int run(const vector<string> &args, bool) {
+  if (args.size() != 3 && args.size() != 5) {
+    throw runtime_error("Error:\twrong number of arguments.");
+  }
+
+  // Open audio
+  if (args.size() == 5) {
+    fasst::AudioReader reader(args[0].c_str(), atoi(args[3].c_str()),
+                              atoi(args[4].c_str()));
+    return computeRx(reader, args);
+  }
+  fasst::AudioReader reader(args[0].c_str());
+  return computeRx(reader, args);
+}
+
+int main(int argc, char *argv[]) {
+  // Run every line of a manifest
+  if (argc == 3 && string(argv[1]) == "--batch") {
+    fasst::Batch batch(argv[2]);
+    return batch.run(&run, 0) == 0 ? 0 : 1;
+  }
+
+  // Read command line args
+  if (argc != 4 && argc != 6) {
+    cout << "Usage:\t" << argv[0]
+         << " input-wav-file input-xml-file output-bin-file"
+            " [input-channels input-samplerate]\n";
+    cout << "\t" << argv[0] << " --batch manifest-file\n";
+    cout << "\tinput-wav-file - reads the standard input, output-bin-file - "
+            "writes the standard output\n";
+    cout << "\tinput-channels and input-samplerate are given for headerless "
+            "32-bit float input\n";
+    cout << "\teach line of manifest-file holds the arguments of one run\n";
+    return 1;
+  }
+
+  return run(vector<string>(argv + 1, argv + argc), true);
+}
@@ -0,0 +1,98 @@
+#include "fasst/Audio.h"
+#include "fasst/LocalSocket.h"
+#include "fasst/ServerProtocol.h"
+#include <cstdlib>
+#include <iostream>
+#include <sys/time.h>
+
+using namespace std;
+
+static double now() {
+  timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+int main(int argc, char *argv[]) {
+  // Read command line args
+  if (argc != 5 && argc != 6) {
+    cout << "Usage:\t" << argv[0]
+         << " socket-path model-index input-wav-file output-wav-dir "
+            "[output-format]\n";
+    cout << "\toutput-format is one of pcm16 (default), pcm24, float, flac "
+            "and raw\n";
+    return 1;
+  }
+
+  // Read audio
+  fasst::Audio x(argv[3]);
+  int samples = x.samples();
+  int channels = x.channels();
+
+  // Read output dirname and format
+  string dirname = argv[4];
+  if (dirname[dirname.length() - 1] != '/') {
+    dirname.push_back('/');
+  }
+  string format = "pcm16";
+  if (argc == 6) {
+    format = argv[5];
+  }
+
+  // Send the request
+  double start = now();
+  fasst::LocalSocket socket(argv[1]);
+  fasst::ServerRequest request;
+  request.model = atoi(argv[2]);
+  request.channels = channels;
+  request.samples = samples;
+  request.samplerate = x.samplerate();
+  socket.write(&request, sizeof(request));
+  vector<float> buffer(samples * channels);
+  for (int t = 0; t < samples; t++) {
+    for (int i = 0; i < channels; i++) {
+      buffer[t * channels + i] = static_cast<float>(x(t, i));
+    }
+  }
+  socket.write(&buffer[0], buffer.size() * sizeof(float));
+
+  // Receive the response
+  fasst::ServerResponse response;
+  socket.read(&response, sizeof(response));
+  if (response.status != 0) {
+    string message(response.samples, '\0');
+    socket.read(&message[0], message.size());
+    cerr << message << '\n';
+    return 1;
+  }
+  int J = response.sources;
+  vector<int> sourceChannels(J);
+  socket.read(&sourceChannels[0], J * sizeof(int));
+  buffer.resize(samples * response.channels);
+  socket.read(&buffer[0], buffer.size() * sizeof(float));
+  fasst::ServerTrailer trailer;
+  socket.read(&trailer, sizeof(trailer));
+  double roundTrip = now() - start;
+
+  // Write the sources, each sample holding the channels of every source
+  int first = 0;
+  for (int j = 0; j < J; j++) {
+    fasst::Audio y(Eigen::ArrayXXd(samples, sourceChannels[j]),
+                   x.samplerate());
+    for (int t = 0; t < samples; t++) {
+      for (int i = 0; i < sourceChannels[j]; i++) {
+        y(t, i) = buffer[t * response.channels + first + i];
+      }
+    }
+    first += sourceChannels[j];
+    stringstream ss;
+    ss << j;
+    y.write(dirname + "y" + ss.str() + fasst::AudioWriter::extension(format),
+            x.samplerate(), format);
+  }
+
+  cout << "Server latency: " << trailer.latency * 1e-3 << " ms\n";
+  cout << "Round trip: " << roundTrip * 1e3 << " ms\n";
+
+  return 0;
+}
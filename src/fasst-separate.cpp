@@ -0,0 +1,155 @@
+#include "fasst/Audio.h"
+#include "fasst/XMLDoc.h"
+#include "fasst/TFRepr.h"
+#include "fasst/MixCovMatrix.h"
+#include "fasst/Sources.h"
+#include "fasst/SourceSink.h"
+#include "fasst/GEM.h"
+#include "fasst/MiniBatchGEM.h"
+#include "fasst/Threads.h"
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+static void estimate(fasst::Sources &sources,
+                     const fasst::MixCovMatrix &hatRx, int iterations,
+                     int miniBatchFrames, bool verbose) {
+  // With mini-batches, each iteration but the last one only visits a block of
+  // frames, so the log-likelihoods are not comparable
+  if (miniBatchFrames > 0 && miniBatchFrames < hatRx.frames()) {
+    fasst::MiniBatchGEM gem(sources, hatRx, iterations, miniBatchFrames);
+    for (int iter = 0; iter < iterations; iter++) {
+      double log_like = gem.next();
+      if (verbose) {
+        cout << "GEM iteration " << iter + 1 << " of " << iterations << '\t';
+        cout << (iter == iterations - 1 ? "Log-likelihood: "
+                                        : "Block log-likelihood: ")
+             << log_like << '\n';
+      }
+    }
+  } else {
+    fasst::GEM gem(sources, hatRx, iterations);
+    double log_like_prev = 0;
+    for (int iter = 0; iter < iterations; iter++) {
+      double log_like = gem.next();
+      if (!verbose) {
+        continue;
+      }
+      cout << "GEM iteration " << iter + 1 << " of " << iterations << '\t';
+      if (iter == 0)
+        cout << "Log-likelihood: " << log_like << '\n';
+      else {
+        cout << "Log-likelihood: " << log_like << '\t';
+        cout << "Improvement: " << log_like - log_like_prev << '\n';
+      }
+      log_like_prev = log_like;
+    }
+  }
+
+  // GEM only updates the global mixing parameter
+  sources.syncMixingParameter();
+}
+
+static void filter(fasst::Sources &sources, const fasst::Audio &x,
+                   const string &tfr_type, int wlen, int nbin,
+                   int iterations, int miniBatchFrames, bool verbose,
+                   fasst::SourceSink &sink) {
+  // Compute Rx in memory. The STFT of the mixture is kept for the filtering.
+  if (tfr_type == "STFT") {
+    fasst::TFRepr X(x, wlen);
+    {
+      fasst::MixCovMatrix hatRx(X);
+      estimate(sources, hatRx, iterations, miniBatchFrames, verbose);
+    }
+    sources.Filter(X, wlen, x.samples(), sink);
+  } else {
+    {
+      fasst::MixCovMatrix hatRx(x, tfr_type, wlen, nbin);
+      estimate(sources, hatRx, iterations, miniBatchFrames, verbose);
+    }
+    sources.Filter(x, tfr_type, wlen, sink);
+  }
+}
+
+static int run(int argc, char *argv[]) {
+  // Keep each thread on the same frames and processor across the iterations,
+  // if FASST_PIN_THREADS is set
+  fasst::pinThreads();
+
+  // Read audio
+  fasst::Audio x(argv[1]);
+
+  // Read TFR parameters and sources from XML
+  fasst::XMLDoc doc(argv[2]);
+  std::string tfr_type = doc.getTFRType();
+  int wlen = doc.getWlen();
+  int nbin = doc.getNbin();
+  fasst::Sources sources = doc.getSources();
+  int J = sources.size();
+
+  // Read output dirname and format
+  string dirname = argv[3];
+  bool toStdout = dirname == "-";
+  if (dirname[dirname.length() - 1] != '/') {
+    dirname.push_back('/');
+  }
+  string format = toStdout ? "raw" : "pcm16";
+  if (argc == 5) {
+    format = argv[4];
+  }
+
+  // Define number of iterations
+  int iterations = doc.getIterations();
+  if (iterations == 0) {
+    iterations = 50;
+  }
+  int miniBatchFrames = doc.getMiniBatchFrames();
+
+  // Progress is not shown when the standard output carries audio
+  if (toStdout) {
+    fasst::SourceMultiplexer sink("-", x.samplerate(), format);
+    filter(sources, x, tfr_type, wlen, nbin, iterations, miniBatchFrames,
+           false, sink);
+    return 0;
+  }
+
+  vector<string> fnames(J);
+  for (int j = 0; j < J; j++) {
+    string srcname;
+    if (sources[j].name().empty()) {
+      stringstream ss;
+      ss << j;
+      srcname = "y" + ss.str();
+    } else {
+      srcname = sources[j].name();
+    }
+    fnames[j] = dirname + srcname + fasst::AudioWriter::extension(format);
+  }
+  fasst::SourceWriter sink(fnames, x.samplerate(), format);
+  filter(sources, x, tfr_type, wlen, nbin, iterations, miniBatchFrames, true,
+         sink);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  // Read command line args
+  if (argc != 4 && argc != 5) {
+    cout << "Usage:\t" << argv[0]
+         << " input-wav-file input-xml-file output-wav-dir [output-format]\n";
+    cout << "\toutput-format is one of pcm16 (default), pcm24, float, flac "
+            "and raw\n";
+    cout << "\tinput-wav-file - reads the standard input, output-wav-dir - "
+            "writes all the sources one after the other in each sample to "
+            "the standard output (raw by default)\n";
+    return 1;
+  }
+
+  try {
+    return run(argc, argv);
+  } catch (const exception &e) {
+    cerr << e.what() << '\n';
+    return 1;
+  }
+}
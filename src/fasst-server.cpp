@@ -0,0 +1,202 @@
+#include "fasst/Audio.h"
+#include "fasst/XMLDoc.h"
+#include "fasst/Sources.h"
+#include "fasst/SourceSink.h"
+#include "fasst/LocalSocket.h"
+#include "fasst/ServerProtocol.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <sys/time.h>
+
+using namespace std;
+
+// A model which is parsed and prepared once, when the server starts
+struct Model {
+  string tfr_type;
+  int wlen;
+  fasst::Sources *sources;
+};
+
+// Sends the blocks of the sources to the client as soon as they are estimated.
+// The response header is only sent with the first block, which gives the
+// number of channels of each source, so that an error which occurs before can
+// still be reported.
+class SocketSink : public fasst::SourceSink {
+public:
+  SocketSink(fasst::LocalSocket &socket, int samples)
+      : m_socket(socket), m_started(false) {
+    m_response.status = 0;
+    m_response.samples = samples;
+  }
+
+  void write(const vector<Eigen::ArrayXXd> &y) {
+    int J = static_cast<int>(y.size());
+    if (!m_started) {
+      vector<int> channels(J);
+      m_response.sources = J;
+      m_response.channels = 0;
+      for (int j = 0; j < J; j++) {
+        channels[j] = static_cast<int>(y[j].cols());
+        m_response.channels += channels[j];
+      }
+      m_socket.write(&m_response, sizeof(m_response));
+      m_socket.write(&channels[0], J * sizeof(int));
+      m_started = true;
+    }
+    int rows = static_cast<int>(y[0].rows());
+    m_buffer.resize(rows * m_response.channels);
+    for (int t = 0; t < rows; t++) {
+      float *sample = &m_buffer[t * m_response.channels];
+      for (int j = 0; j < J; j++) {
+        for (int i = 0; i < y[j].cols(); i++) {
+          *sample++ = static_cast<float>(y[j](t, i));
+        }
+      }
+    }
+    if (rows > 0) {
+      m_socket.write(&m_buffer[0], m_buffer.size() * sizeof(float));
+    }
+  }
+
+  bool started() const { return m_started; }
+
+private:
+  fasst::LocalSocket &m_socket;
+  fasst::ServerResponse m_response;
+  bool m_started;
+  vector<float> m_buffer;
+};
+
+static double now() {
+  timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void sendError(fasst::LocalSocket &client, const string &message) {
+  fasst::ServerResponse response;
+  response.status = 1;
+  response.sources = 0;
+  response.channels = 0;
+  response.samples = static_cast<int>(message.size());
+  client.write(&response, sizeof(response));
+  client.write(message.data(), message.size());
+}
+
+// Largest mixture accepted, in samples times channels (1 GiB of floats)
+static const size_t MAX_REQUEST_VALUES = static_cast<size_t>(1) << 28;
+
+// Serves one request, returns the latency in seconds
+static double serve(fasst::LocalSocket &client, vector<Model> &models) {
+  fasst::ServerRequest request;
+  client.read(&request, sizeof(request));
+  double start = now();
+
+  int nModels = static_cast<int>(models.size());
+  if (request.model < 0 || request.model >= nModels) {
+    stringstream s;
+    s << "Error:\tmodel index " << request.model << " is out of range, "
+      << nModels << " models are loaded.";
+    sendError(client, s.str());
+    throw runtime_error(s.str());
+  }
+  Model &model = models[request.model];
+  size_t values = static_cast<size_t>(request.samples) *
+                  static_cast<size_t>(request.channels);
+  if (request.channels <= 0 || request.samples <= 0 ||
+      values > MAX_REQUEST_VALUES) {
+    stringstream s;
+    s << "Error:\tinvalid request of " << request.samples << " samples of "
+      << request.channels << " channels.";
+    sendError(client, s.str());
+    throw runtime_error(s.str());
+  }
+  if (request.channels != model.sources->channels()) {
+    stringstream s;
+    s << "Error:\tthe mixture has " << request.channels << " channels, model "
+      << request.model << " has " << model.sources->channels() << '.';
+    sendError(client, s.str());
+    throw runtime_error(s.str());
+  }
+  if (model.tfr_type == "ERB" && request.samplerate <= 0) {
+    stringstream s;
+    s << "Error:\tinvalid samplerate " << request.samplerate
+      << ", model " << request.model << " uses the ERB transform.";
+    sendError(client, s.str());
+    throw runtime_error(s.str());
+  }
+
+  // Receive the mixture
+  vector<float> buffer(values);
+  client.read(&buffer[0], buffer.size() * sizeof(float));
+  typedef Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      InterleavedArray;
+  fasst::Audio x(Eigen::Map<InterleavedArray>(&buffer[0], request.samples,
+                                              request.channels)
+                     .cast<double>(),
+                 request.samplerate);
+
+  // Wiener filter, the sources are sent while they are estimated
+  SocketSink sink(client, request.samples);
+  try {
+    model.sources->Filter(x, model.tfr_type, model.wlen, sink);
+  } catch (const exception &e) {
+    if (!sink.started()) {
+      sendError(client, e.what());
+    }
+    throw;
+  }
+
+  double latency = now() - start;
+  fasst::ServerTrailer trailer;
+  trailer.latency = static_cast<int>(latency * 1e6);
+  client.write(&trailer, sizeof(trailer));
+  return latency;
+}
+
+int main(int argc, char *argv[]) {
+  // Read command line args
+  if (argc < 4) {
+    cout << "Usage:\t" << argv[0]
+         << " socket-path latency-budget-ms input-xml-file "
+            "[input-xml-file ...]\n";
+    cout << "\tModels are numbered from 0 in the order of the command line. "
+            "A latency-budget-ms of 0 disables the budget warnings.\n";
+    return 1;
+  }
+  double budget = atof(argv[2]) * 1e-3;
+
+  // Parse the models and precompute their Wiener filters
+  vector<Model> models(argc - 3);
+  for (int m = 0; m < argc - 3; m++) {
+    fasst::XMLDoc doc(argv[m + 3]);
+    models[m].tfr_type = doc.getTFRType();
+    models[m].wlen = doc.getWlen();
+    models[m].sources = new fasst::Sources(doc.getSources());
+    models[m].sources->prepareFilter();
+    cout << "Model " << m << ": " << argv[m + 3] << '\n';
+  }
+
+  // A client which goes away must not kill the server
+  signal(SIGPIPE, SIG_IGN);
+
+  int listener = fasst::LocalSocket::listen(argv[1]);
+  cout << "Listening on " << argv[1] << endl;
+  while (true) {
+    fasst::LocalSocket client(fasst::LocalSocket::accept(listener));
+    try {
+      double latency = serve(client, models);
+      cout << "Request served in " << latency * 1e3 << " ms" << endl;
+      if (budget > 0 && latency > budget) {
+        cerr << "Warning:\tlatency of " << latency * 1e3
+             << " ms exceeds the budget of " << budget * 1e3 << " ms\n";
+      }
+    } catch (const exception &e) {
+      cerr << e.what() << '\n';
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,214 @@
+#include "fasst/Audio.h"
+#include "fasst/TFRepr.h"
+#include "fasst/MixCovMatrix.h"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace Eigen;
+
+static const int SAMPLERATE = 16000;
+
+// Pseudo-random generator whose sequence only depends on the seed, so that a
+// workload is the same on every platform
+class Random {
+public:
+  Random(unsigned long seed)
+      : m_state(seed * 2862933555777941757ULL + 3037000493ULL) {}
+
+  // Uniform value in (0, 1)
+  double uniform() {
+    m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ((m_state >> 11) + 0.5) / 9007199254740992.;
+  }
+
+  // Standard normal value
+  double normal() {
+    double u = uniform();
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * uniform());
+  }
+
+  // Positive value, as for the NMF parameters of the FASST examples
+  double positive() { return 0.75 * abs(normal()) + 0.25; }
+
+private:
+  unsigned long long m_state;
+};
+
+// Random nonnegative matrix
+static MatrixXd nonNegative(Random &random, int rows, int cols) {
+  MatrixXd m(rows, cols);
+  for (int i = 0; i < cols; i++) {
+    for (int j = 0; j < rows; j++) {
+      m(j, i) = random.positive();
+    }
+  }
+  return m;
+}
+
+// Writes the XML element of a nonnegative matrix
+static void writeNonNegMatrix(ostream &out, const string &tag,
+                              const MatrixXd &m) {
+  out << "<" << tag << " adaptability=\"free\">\n";
+  out << "<rows>" << m.rows() << "</rows>\n";
+  out << "<cols>" << m.cols() << "</cols>\n";
+  out << "<data>";
+  for (int i = 0; i < m.cols(); i++) {
+    for (int j = 0; j < m.rows(); j++) {
+      out << m(j, i) << ' ';
+    }
+    out << '\n';
+  }
+  out << "</data>\n</" << tag << ">\n";
+}
+
+// Writes the XML element of a fixed identity matrix, which the sources need in
+// place of the U and G matrices they don't use
+static void writeEye(ostream &out, const string &tag, int dim) {
+  out << "<" << tag << " adaptability=\"fixed\">\n";
+  out << "<rows>" << dim << "</rows>\n";
+  out << "<cols>" << dim << "</cols>\n";
+  out << "<data>eye</data>\n</" << tag << ">\n";
+}
+
+// Writes the XML element of a random mixing parameter of rank 1
+static void writeMixingParameter(ostream &out, Random &random,
+                                 const string &mixing, int I, int F) {
+  bool conv = mixing != "inst";
+  bool isComplex = mixing == "conv-complex";
+  out << "<A adaptability=\"free\" mixing_type=\"" << (conv ? "conv" : "inst")
+      << "\">\n";
+  out << "<ndims>" << (conv ? 3 : 2) << "</ndims>\n";
+  out << "<dim>" << I << "</dim>\n<dim>1</dim>\n";
+  if (conv) {
+    out << "<dim>" << F << "</dim>\n";
+  }
+  out << "<type>" << (isComplex ? "complex" : "real") << "</type>\n";
+  out << "<data>";
+  int values = I * (conv ? F : 1) * (isComplex ? 2 : 1);
+  for (int k = 0; k < values; k++) {
+    out << random.normal() << ' ';
+  }
+  out << "</data>\n</A>\n";
+}
+
+int main(int argc, char *argv[]) {
+  // Read command line args
+  if (argc != 9 && argc != 10 && argc != 11) {
+    cout << "Usage:\t" << argv[0]
+         << " output-dir seed channels seconds sources rank mixing tfr-type "
+            "[wlen [nbin]]\n";
+    cout << "\tmixing is one of inst, conv-real and conv-complex, tfr-type "
+            "one of STFT and ERB\n";
+    cout << "\twlen is 1024 and nbin 64 by default\n";
+    cout << "\twrites mix.wav, the source images ref<j>.wav, Rx.bin and the "
+            "initial sources.xml to output-dir\n";
+    return 1;
+  }
+  string dirname = argv[1];
+  if (dirname[dirname.length() - 1] != '/') {
+    dirname.push_back('/');
+  }
+  unsigned long seed = strtoul(argv[2], 0, 10);
+  int I = atoi(argv[3]);
+  double seconds = atof(argv[4]);
+  int J = atoi(argv[5]);
+  int K = atoi(argv[6]);
+  string mixing = argv[7];
+  string tfr_type = argv[8];
+  int wlen = argc > 9 ? atoi(argv[9]) : 1024;
+  int nbin = argc > 10 ? atoi(argv[10]) : 64;
+  int samples = static_cast<int>(seconds * SAMPLERATE);
+  if (I <= 0 || J <= 0 || K <= 0 || wlen <= 0 || nbin <= 0 || samples < wlen) {
+    cout << "Error:\tchannels, sources, rank, wlen and nbin must be positive "
+            "and the signal must be longer than a window.\n";
+    return 1;
+  }
+  if (mixing != "inst" && mixing != "conv-real" && mixing != "conv-complex") {
+    cout << "Error:\tunknown mixing " << mixing << ".\n";
+    return 1;
+  }
+  if (tfr_type != "STFT" && tfr_type != "ERB") {
+    cout << "Error:\tunknown TFR type " << tfr_type << ".\n";
+    return 1;
+  }
+  Random random(seed);
+
+  // The source images are drawn in the STFT domain: each source is a complex
+  // Gaussian process whose variance is an NMF of rank K, spread over the
+  // channels by gains, and by delays for convolutive mixtures
+  fasst::TFRepr shape(fasst::Audio(ArrayXXd::Zero(samples, 1), SAMPLERATE),
+                      wlen);
+  int F = shape.bins();
+  int N = shape.frames();
+  vector<fasst::Audio> y(J);
+  fasst::Audio x(ArrayXXd::Zero(samples, I), SAMPLERATE);
+  for (int j = 0; j < J; j++) {
+    MatrixXd V = nonNegative(random, F, K) * nonNegative(random, K, N);
+    VectorXd gains(I), delays(I);
+    for (int i = 0; i < I; i++) {
+      gains(i) = random.positive();
+      delays(i) = mixing == "inst" ? 0 : random.uniform() * 16;
+    }
+    fasst::TFRepr Y(F, N);
+    for (int f = 0; f < F; f++) {
+      VectorXcd A(I);
+      for (int i = 0; i < I; i++) {
+        A(i) = polar(gains(i), -M_PI * f * delays(i) / (F - 1));
+      }
+      for (int n = 0; n < N; n++) {
+        complex<double> s(random.normal(), random.normal());
+        Y(f, n) = A * s * sqrt(V(f, n) / 2);
+      }
+    }
+    y[j] = fasst::Audio(Y.inverse(wlen, samples), SAMPLERATE);
+    x += y[j];
+  }
+
+  // Scale the signals so that the mixture doesn't clip
+  double scale = 0.9 / x.abs().maxCoeff();
+  x *= scale;
+  x.write(dirname + "mix.wav", SAMPLERATE, "float");
+  for (int j = 0; j < J; j++) {
+    y[j] *= scale;
+    stringstream fname;
+    fname << dirname << "ref" << j << ".wav";
+    y[j].write(fname.str(), SAMPLERATE, "float");
+  }
+
+  // Compute Rx
+  fasst::MixCovMatrix hatRx(x, tfr_type, wlen, nbin);
+  hatRx.write((dirname + "Rx.bin").c_str());
+
+  // Write the initial sources, with the dimensions of Rx
+  string fname = dirname + "sources.xml";
+  ofstream out(fname.c_str());
+  if (!out.good()) {
+    stringstream s;
+    s << "Can not open " << fname << ". ";
+    s << "You probably don't have write access to this location.";
+    throw runtime_error(s.str());
+  }
+  out << "<sources>\n";
+  out << "<tfr_type>" << tfr_type << "</tfr_type>\n";
+  out << "<wlen>" << wlen << "</wlen>\n";
+  if (tfr_type == "ERB") {
+    out << "<nbin>" << nbin << "</nbin>\n";
+  }
+  for (int j = 0; j < J; j++) {
+    out << "<source>\n";
+    writeMixingParameter(out, random, mixing, I, hatRx.bins());
+    writeNonNegMatrix(out, "Wex", nonNegative(random, hatRx.bins(), K));
+    writeEye(out, "Uex", K);
+    writeEye(out, "Gex", K);
+    writeNonNegMatrix(out, "Hex", nonNegative(random, K, hatRx.frames()));
+    out << "</source>\n";
+  }
+  out << "</sources>\n";
+
+  return 0;
+}
@@ -1,37 +1,101 @@
 #include "Audio.h"
 #include <sndfile.hh>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
 #include <vector>
+#include <sstream>
 #include <stdexcept>
 
 using namespace std;
 using namespace Eigen;
 
 namespace fasst {
-Audio::Audio(const char *fname) {
-  // Open fname
-  SndfileHandle wavFile(fname);
-  if (wavFile.error()) {
-    stringstream s;
-    s << "Can not open " << fname << ". ";
-    s << wavFile.strError();
-    throw runtime_error(s.str());
+
+// Number of samples in one tile of the blocked transposes below: a tile of an
+// interleaved buffer with 16 channels in double precision takes 32 kB
+static const int TILE_SAMPLES = 256;
+
+/*!
+ Copies interleaved audio samples to rows of a samples-by-channels array. The
+ interleaved buffer is seen as a row-major array and copied tile by tile, so
+ that both sides are accessed within the cache.
+ \param buffer the interleaved audio samples
+ \param samples the number of samples
+ \param x the samples-by-channels array
+ \param first the row of the array corresponding to the first sample
+ */
+template <typename ArrayType, typename Scalar>
+static void deinterleave(const Scalar *buffer, int samples, ArrayType &x,
+                         int first) {
+  typedef Eigen::Array<Scalar, Dynamic, Dynamic, RowMajor> RowMajorArray;
+  int channels = x.cols();
+  Map<const RowMajorArray> in(buffer, samples, channels);
+  for (int t = 0; t < samples; t += TILE_SAMPLES) {
+    int count = std::min(TILE_SAMPLES, samples - t);
+    x.block(first + t, 0, count, channels) =
+        in.middleRows(t, count).template cast<typename ArrayType::Scalar>();
+  }
+}
+
+/*!
+ Copies rows of a samples-by-channels array to interleaved audio samples. This
+ is the inverse of deinterleave.
+ \param x the samples-by-channels array
+ \param first the row of the array corresponding to the first sample
+ \param samples the number of samples
+ \param buffer the interleaved audio samples
+ */
+template <typename ArrayType, typename Scalar>
+static void interleave(const ArrayType &x, int first, int samples,
+                       Scalar *buffer) {
+  typedef Eigen::Array<Scalar, Dynamic, Dynamic, RowMajor> RowMajorArray;
+  int channels = x.cols();
+  Map<RowMajorArray> out(buffer, samples, channels);
+  for (int t = 0; t < samples; t += TILE_SAMPLES) {
+    int count = std::min(TILE_SAMPLES, samples - t);
+    out.middleRows(t, count) =
+        x.block(first + t, 0, count, channels).template cast<Scalar>();
   }
+}
+
+Audio::Audio(const char *fname) {
+  AudioReader reader(fname);
+  read(reader);
+}
+
+Audio::Audio(AudioReader &reader) { read(reader); }
 
-  // Read fname to a buffer
-  int samples = static_cast<int>(wavFile.frames());
-  int channels = wavFile.channels();
-  unsigned int buffer_size = samples * channels;
-  vector<double> buffer(buffer_size);
-  wavFile.read(&buffer[0], buffer_size);
-
-  // Load audio data
-  _set(ArrayXXd(samples, channels));
-  for (int i = 0; i < samples; i++) {
-    for (int j = 0; j < channels; j++) {
-      (*this)(i, j) = buffer[i * channels + j];
+void Audio::read(AudioReader &reader) {
+  int samples = reader.samples();
+  int channels = reader.channels();
+  resize(std::max(samples, 0), channels);
+  m_samplerate = reader.samplerate();
+
+  // Load audio data block by block. If the length of the stream is unknown,
+  // the array grows geometrically until the end of the stream.
+  int first = 0;
+  while (samples < 0 || first < samples) {
+    int count = 65536;
+    if (samples >= 0) {
+      count = std::min(count, samples - first);
+    } else if (first + count > rows()) {
+      conservativeResize(std::max(2 * static_cast<int>(rows()), first + count),
+                         NoChange);
+    }
+    count = reader.read(*this, first, count);
+    if (count == 0) {
+      break;
     }
+    first += count;
+  }
+
+  if (samples < 0) {
+    conservativeResize(first, NoChange);
+  } else {
+    // Truncated files are zero-padded
+    bottomRows(samples - first).setZero();
   }
-  m_samplerate = wavFile.samplerate();
 }
 
 void Audio::write(const string &fname, int samplerate) {
@@ -39,27 +103,141 @@ void Audio::write(const string &fname, int samplerate) {
     write(fname);
 }
 
-void Audio::write(const string &fname) {
-  // Open fname
-  SndfileHandle wavFile = SndfileHandle(
-      fname, SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_PCM_16, channels(), m_samplerate);
-  if (wavFile.error()) {
+void Audio::write(const string &fname) { write(fname, m_samplerate, "pcm16"); }
+
+void Audio::write(const string &fname, int samplerate, const string &format) {
+  m_samplerate = samplerate;
+  AudioWriter writer(fname, channels(), m_samplerate, format);
+  writer.write(*this);
+}
+
+AudioReader::AudioReader(const char *fname) { open(fname, 0, 0, 0); }
+
+AudioReader::AudioReader(const char *fname, int channels, int samplerate) {
+  open(fname, SF_FORMAT_RAW | SF_FORMAT_FLOAT, channels, samplerate);
+}
+
+void AudioReader::open(const char *fname, int format, int channels,
+                       int samplerate) {
+  // Open fname, - being the standard input
+  if (string(fname) == "-") {
+    m_file = new SndfileHandle(fileno(stdin), false, SFM_READ, format,
+                               channels, samplerate);
+  } else {
+    m_file = new SndfileHandle(fname, SFM_READ, format, channels, samplerate);
+  }
+  if (m_file->error()) {
+    stringstream s;
+    s << "Can not open " << fname << ". ";
+    s << m_file->strError();
+    delete m_file;
+    throw runtime_error(s.str());
+  }
+
+  // libsndfile reports SF_COUNT_MAX frames for streams of unknown length
+  sf_count_t frames = m_file->frames();
+  m_samples = frames < INT_MAX ? static_cast<int>(frames) : -1;
+  m_channels = m_file->channels();
+  m_samplerate = m_file->samplerate();
+}
+
+AudioReader::~AudioReader() { delete m_file; }
+
+int AudioReader::read(ArrayXXd &block) {
+  return read(block, 0, block.rows());
+}
+
+int AudioReader::read(ArrayXXd &x, int first, int samples) {
+  m_buffer.resize(samples * m_channels);
+  int count = static_cast<int>(m_file->readf(&m_buffer[0], samples));
+  deinterleave(&m_buffer[0], count, x, first);
+  x.block(first + count, 0, samples - count, m_channels).setZero();
+  return count;
+}
+
+int AudioReader::read(ArrayXXf &block) {
+  int samples = block.rows();
+  m_floatBuffer.resize(samples * m_channels);
+  int count = static_cast<int>(m_file->readf(&m_floatBuffer[0], samples));
+  deinterleave(&m_floatBuffer[0], count, block, 0);
+  block.bottomRows(samples - count).setZero();
+  return count;
+}
+
+AudioWriter::AudioWriter(const string &fname, int channels, int samplerate,
+                         const string &format)
+    : m_channels(channels) {
+  int sfFormat;
+  if (format == "pcm16") {
+    sfFormat = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+  } else if (format == "pcm24") {
+    sfFormat = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+  } else if (format == "float") {
+    sfFormat = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+  } else if (format == "flac") {
+    sfFormat = SF_FORMAT_FLAC | SF_FORMAT_PCM_24;
+  } else if (format == "raw") {
+    sfFormat = SF_FORMAT_RAW | SF_FORMAT_FLOAT;
+  } else {
+    stringstream s;
+    s << "Wrong audio format " << format << ".";
+    throw runtime_error(s.str());
+  }
+  m_isFloat = (sfFormat & SF_FORMAT_SUBMASK) == SF_FORMAT_FLOAT;
+
+  // Open fname, - being the standard output
+  if (fname == "-") {
+    m_file = new SndfileHandle(fileno(stdout), false, SFM_WRITE, sfFormat,
+                               channels, samplerate);
+  } else {
+    m_file =
+        new SndfileHandle(fname, SFM_WRITE, sfFormat, channels, samplerate);
+  }
+  if (m_file->error()) {
     stringstream s;
     s << "Can not open " << fname << ". ";
     s << "You probably don't have write access to this location.";
+    delete m_file;
     throw runtime_error(s.str());
   }
+}
+
+AudioWriter::~AudioWriter() { delete m_file; }
+
+void AudioWriter::write(const ArrayXXd &x) { write(x, 0, x.rows()); }
 
-  // Load audio data to a buffer
-  unsigned int buffer_size = samples() * channels();
-  vector<double> buffer(buffer_size);
-  for (int i = 0; i < samples(); i++) {
-    for (int j = 0; j < channels(); j++) {
-      buffer[i * channels() + j] = (*this)(i, j);
+void AudioWriter::write(const ArrayXXd &x, int first, int samples) {
+  if (x.cols() != m_channels) {
+    stringstream s;
+    s << "Error:\tcan not write " << x.cols()
+      << " channels to an audio file of " << m_channels << " channels.";
+    throw runtime_error(s.str());
+  }
+
+  // Float samples are written as they are, other formats are converted by
+  // libsndfile from double precision
+  int blockSize = 4096;
+  for (int t = 0; t < samples; t += blockSize) {
+    int count = std::min(blockSize, samples - t);
+    if (m_isFloat) {
+      m_floatBuffer.resize(count * m_channels);
+      interleave(x, first + t, count, &m_floatBuffer[0]);
+      m_file->writef(&m_floatBuffer[0], count);
+    } else {
+      m_buffer.resize(count * m_channels);
+      interleave(x, first + t, count, &m_buffer[0]);
+      m_file->writef(&m_buffer[0], count);
     }
   }
+}
 
-  // Write buffer
-  wavFile.write(&buffer[0], buffer_size);
+string AudioWriter::extension(const string &format) {
+  if (format == "flac") {
+    return ".flac";
+  } else if (format == "raw") {
+    return ".raw";
+  } else {
+    return ".wav";
+  }
 }
 }
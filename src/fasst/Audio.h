@@ -2,8 +2,13 @@
 #define FASST_AUDIO_H
 
 #include <Eigen/Core>
+#include <string>
+#include <vector>
+
+class SndfileHandle;
 
 namespace fasst {
+class AudioReader;
 
 /*!
  This class contains audio data. The audio data is stored in an
@@ -20,6 +25,12 @@ public:
    */
   Audio(const char *fname);
 
+  /*!
+   This constructor reads all the remaining audio data of a reader.
+   \param reader an audio reader
+   */
+  Audio(AudioReader &reader);
+
   Audio(){};
 
   /*!
@@ -29,6 +40,15 @@ public:
    */
   Audio(const Eigen::ArrayXXd &x) : Eigen::ArrayXXd(x) {}
 
+  /*!
+   This constructor build an Audio object from audio data stored in an
+   `Eigen::ArrayXXd` object and its samplerate.
+   \param x the audio data to be copied
+   \param samplerate the samplerate
+   */
+  Audio(const Eigen::ArrayXXd &x, int samplerate)
+      : Eigen::ArrayXXd(x), m_samplerate(samplerate) {}
+
   /*!
    This method writes the audio data to a file, at a given sample rate. Please note that if the file is not writable, the method will throw a `runtime_error` exception.
 
@@ -45,6 +65,17 @@ public:
    */
   void write(const std::string &fname);
 
+  /*!
+   This method writes the audio data to a file, at a given sample rate and in
+   a given sample format. Please note that if the file is not writable or the
+   format is unknown, the method will throw a `runtime_error` exception.
+
+   \param fname the name of the audio file to be written
+   \param samplerate the samplerate to be written
+   \param format the sample format, see AudioWriter::AudioWriter
+   */
+  void write(const std::string &fname, int samplerate, const std::string &format);
+
   /*!
    \return the number of audio samples
    */
@@ -61,8 +92,166 @@ public:
   inline int samplerate() const { return m_samplerate; }
 
 private:
+  /*!
+   This method reads all the remaining audio data of a reader.
+   \param reader an audio reader
+   */
+  void read(AudioReader &reader);
+
+  int m_samplerate;
+};
+
+/*!
+ This class reads audio data from a WAV file block by block, so that the whole
+ file never has to be held in memory by the reader. Each block is deinterleaved
+ on the fly into an `Eigen` array in which rows are audio samples and columns
+ are audio channels, as in Audio.
+ */
+class AudioReader {
+public:
+  /*!
+   The main constructor of the class opens a WAV file and reads its header.
+   Please note that if the file is not readable, the constructor will throw a
+   `runtime_error` exception.
+   \param fname the name of the WAV file to be read, or `-` for the standard
+   input
+   */
+  AudioReader(const char *fname);
+
+  /*!
+   This constructor opens a headerless file of interleaved 32-bit floating
+   point samples, such as the ones written by AudioWriter in the `raw` format.
+   \param fname the name of the raw file to be read, or `-` for the standard
+   input
+   \param channels the number of audio channels
+   \param samplerate the samplerate
+   */
+  AudioReader(const char *fname, int channels, int samplerate);
+
+  ~AudioReader();
+
+  /*!
+   This method reads the next audio samples of the file. The number of samples
+   to be read is the number of rows of the block, which must have one column
+   per channel. If the end of the file is reached, the remaining rows of the
+   block are set to zero.
+   \param block the samples-by-channels array to be filled
+   \return the number of samples actually read
+   */
+  int read(Eigen::ArrayXXd &block);
+
+  /*!
+   This method reads the next audio samples of the file to some rows of an
+   array, without going through an intermediate block. If the end of the file
+   is reached, the remaining rows are set to zero.
+   \param x the samples-by-channels array to be filled
+   \param first the first row to be filled
+   \param samples the number of samples to be read
+   \return the number of samples actually read
+   */
+  int read(Eigen::ArrayXXd &x, int first, int samples);
+
+  /*!
+   This method does the same as the previous one, in single precision.
+   \param block the samples-by-channels array to be filled
+   \return the number of samples actually read
+   */
+  int read(Eigen::ArrayXXf &block);
+
+  /*!
+   \return the number of audio samples in the file, or -1 if it is not known
+   before the end of the stream, _eg._ when reading from a pipe
+   */
+  inline int samples() const { return m_samples; }
+
+  /*!
+   \return the number of audio channels
+   */
+  inline int channels() const { return m_channels; }
+
+  /*!
+   \return the samplerate
+   */
+  inline int samplerate() const { return m_samplerate; }
+
+private:
+  AudioReader(const AudioReader &);
+  AudioReader &operator=(const AudioReader &);
+
+  void open(const char *fname, int format, int channels, int samplerate);
+
+  SndfileHandle *m_file;
+  std::vector<double> m_buffer;
+  std::vector<float> m_floatBuffer;
+  int m_samples;
+  int m_channels;
   int m_samplerate;
 };
+
+/*!
+ This class writes audio data to a file block by block. Each block is
+ interleaved on the fly in a small buffer, so that the whole signal never has
+ to be copied before being written.
+ */
+class AudioWriter {
+public:
+  /*!
+   The main constructor of the class opens an audio file for writing. Please
+   note that if the file is not writable or the format is unknown, the
+   constructor will throw a `runtime_error` exception.
+   \param fname the name of the audio file to be written, or `-` for the
+   standard output
+   \param channels the number of audio channels
+   \param samplerate the samplerate
+   \param format the sample format, which is one of:
+   - `pcm16`: 16-bit integer WAV
+   - `pcm24`: 24-bit integer WAV
+   - `float`: 32-bit floating point WAV
+   - `flac`: 24-bit FLAC
+   - `raw`: headerless interleaved 32-bit floating point samples
+
+   Pipes can't be rewound to complete a file header, so the `raw` format
+   should be used with the standard output.
+   */
+  AudioWriter(const std::string &fname, int channels, int samplerate,
+              const std::string &format);
+
+  ~AudioWriter();
+
+  /*!
+   This method writes all the rows of a samples-by-channels array after the
+   previously written samples. Please note that if the array doesn't have the
+   number of channels of the file, the method will throw a `runtime_error`
+   exception.
+   \param x the samples-by-channels array
+   */
+  void write(const Eigen::ArrayXXd &x);
+
+  /*!
+   This method writes some rows of a samples-by-channels array after the
+   previously written samples.
+   \param x the samples-by-channels array
+   \param first the first row to be written
+   \param samples the number of rows to be written
+   */
+  void write(const Eigen::ArrayXXd &x, int first, int samples);
+
+  /*!
+   \param format a sample format
+   \return the usual file name extension for the format
+   */
+  static std::string extension(const std::string &format);
+
+private:
+  AudioWriter(const AudioWriter &);
+  AudioWriter &operator=(const AudioWriter &);
+
+  SndfileHandle *m_file;
+  bool m_isFloat;
+  std::vector<double> m_buffer;
+  std::vector<float> m_floatBuffer;
+  int m_channels;
+};
 }
 
 #endif
@@ -1,4 +1,6 @@
 #include "Audio.h"
+#include "SourceSink.h"
+#include <stdexcept>
 #include "gtest/gtest.h"
 
 using namespace std;
@@ -27,3 +29,80 @@ TEST(Audio, write) {
   // http://www.mega-nerd.com/libsndfile/FAQ.html#Q010
   ASSERT_LT((x1 - x2).abs().maxCoeff(), 1. / 16369);
 }
+
+TEST(AudioReader, blocks) {
+  string fname(g_inputDataDir + "/Shannon_Hurley__Sunrise__inst__mix.wav");
+  fasst::Audio x(fname.c_str());
+
+  // Read the same file with blocks which don't divide its length
+  fasst::AudioReader reader(fname.c_str());
+  ASSERT_EQ(x.channels(), reader.channels());
+  ASSERT_EQ(x.samples(), reader.samples());
+  ArrayXXd block(4096, reader.channels());
+  int first = 0;
+  int count;
+  while ((count = reader.read(block)) > 0) {
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < x.channels(); j++) {
+        ASSERT_EQ(x(first + i, j), block(i, j));
+      }
+    }
+    first += count;
+  }
+  ASSERT_EQ(x.samples(), first);
+
+  // The rows after the end of the file are zeros
+  ASSERT_EQ(0., block.abs().maxCoeff());
+}
+
+TEST(AudioWriter, float) {
+  string fname(g_inputDataDir + "/Shannon_Hurley__Sunrise__inst__mix.wav");
+  fasst::Audio x1(fname.c_str());
+
+  // Write the signal in blocks which don't divide its length
+  {
+    fasst::AudioWriter writer("tmp_float.wav", x1.channels(), x1.samplerate(),
+                              "float");
+    for (int first = 0; first < x1.samples(); first += 3000) {
+      writer.write(x1, first, min(3000, x1.samples() - first));
+    }
+  }
+
+  fasst::Audio x2("tmp_float.wav");
+  ASSERT_EQ(x1.channels(), x2.channels());
+  ASSERT_EQ(x1.samples(), x2.samples());
+  ASSERT_LT((x1 - x2).abs().maxCoeff(), 1e-6);
+}
+
+TEST(AudioWriter, wrongChannels) {
+  ArrayXXd x = ArrayXXd::Zero(100, 2);
+  fasst::AudioWriter writer("tmp_channels.wav", 1, 16000, "float");
+  ASSERT_THROW(writer.write(x), runtime_error);
+}
+
+TEST(SourceWriter, channels) {
+  // With the ERB transform, each source has as many channels as its rank
+  vector<ArrayXXd> y(2);
+  y[0] = ArrayXXd::Random(1000, 1);
+  y[1] = ArrayXXd::Random(1000, 3);
+  vector<string> fnames(2);
+  fnames[0] = "tmp_y0.wav";
+  fnames[1] = "tmp_y1.wav";
+  {
+    fasst::SourceWriter writer(fnames, 16000, "float");
+    for (int first = 0; first < 1000; first += 300) {
+      vector<ArrayXXd> block(2);
+      for (int j = 0; j < 2; j++) {
+        block[j] = y[j].middleRows(first, min(300, 1000 - first));
+      }
+      writer.write(block);
+    }
+  }
+
+  for (int j = 0; j < 2; j++) {
+    fasst::Audio x(fnames[j].c_str());
+    ASSERT_EQ(y[j].cols(), x.channels());
+    ASSERT_EQ(y[j].rows(), x.samples());
+    ASSERT_LT((y[j] - x).abs().maxCoeff(), 1e-6);
+  }
+}
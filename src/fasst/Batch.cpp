@@ -0,0 +1,97 @@
+#include "Batch.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+namespace fasst {
+Batch::Batch(const char *fname) {
+  // Open fname
+  ifstream in(fname);
+  if (!in.good()) {
+    stringstream s;
+    s << "Can not open " << fname << ". ";
+    s << "File probably doesn't exist or isn't readable.";
+    throw runtime_error(s.str());
+  }
+
+  // Read one job per line
+  string line;
+  int number = 0;
+  while (getline(in, line)) {
+    number++;
+    stringstream s(line);
+    vector<string> args;
+    string arg;
+    while (s >> arg) {
+      args.push_back(arg);
+    }
+    if (args.empty() || args[0][0] == '#') {
+      continue;
+    }
+    m_jobs.push_back(args);
+    m_lines.push_back(number);
+  }
+}
+
+int Batch::run(Job job, int sizeArg) const {
+  int J = size();
+
+  // Sort jobs by size
+  vector<int> small, large;
+  for (int i = 0; i < J; i++) {
+    long bytes = 0;
+    if (sizeArg < static_cast<int>(m_jobs[i].size())) {
+      ifstream file(m_jobs[i][sizeArg].c_str(), ios_base::binary);
+      if (file.seekg(0, ios_base::end)) {
+        bytes = static_cast<long>(file.tellg());
+      }
+    }
+    if (bytes >= LARGE_JOB_SIZE) {
+      large.push_back(i);
+    } else {
+      small.push_back(i);
+    }
+  }
+
+  // Small jobs run side by side. The parallel loops inside each job then
+  // run on one thread, since only one level of parallelism is active.
+  int failures = 0;
+#ifdef _OPENMP
+  omp_set_max_active_levels(1);
+#endif
+  int S = small.size();
+#pragma omp parallel for schedule(dynamic) reduction(+ : failures)
+  for (int s = 0; s < S; s++) {
+    failures += runJob(job, small[s]);
+  }
+
+  // Large jobs run one after the other, on every thread
+  for (size_t l = 0; l < large.size(); l++) {
+    failures += runJob(job, large[l]);
+  }
+  return failures;
+}
+
+int Batch::runJob(Job job, int i) const {
+  int status;
+  try {
+    status = job(m_jobs[i], false);
+  } catch (const exception &e) {
+#pragma omp critical(fasst_batch_output)
+    cerr << "Line " << m_lines[i] << ": " << e.what() << '\n';
+    return 1;
+  }
+  if (status != 0) {
+#pragma omp critical(fasst_batch_output)
+    cerr << "Line " << m_lines[i] << ": failed\n";
+    return 1;
+  }
+  return 0;
+}
+}
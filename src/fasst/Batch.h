@@ -0,0 +1,73 @@
+#ifndef FASST_BATCH_H
+#define FASST_BATCH_H
+
+#include <string>
+#include <vector>
+
+namespace fasst {
+
+/*!
+ This class runs many jobs of an executable in one process. The jobs are read
+ from a manifest file in which each line holds the command line arguments of
+ one job, separated by whitespace. Empty lines and lines starting with `#` are
+ ignored.
+
+ Small jobs are distributed across threads, one job per thread, because the
+ work inside one small file is too short to be shared efficiently. Large jobs
+ are then run one after the other, each of them using every thread. The size
+ of a job is the size of one of its files.
+ */
+class Batch {
+public:
+  /*!
+   A job takes the command line arguments of one run of an executable and
+   returns 0 on success. Jobs which are not verbose don't write to the standard
+   output. Errors are reported with `runtime_error` exceptions.
+   */
+  typedef int (*Job)(const std::vector<std::string> &args, bool verbose);
+
+  /*!
+   The main constructor of the class reads a manifest file. Please note that if
+   the file is not readable, the constructor will throw a `runtime_error`
+   exception.
+   \param fname the name of the manifest file
+   */
+  Batch(const char *fname);
+
+  /*!
+   This method runs every job of the manifest. The errors of one job are
+   reported on the standard error and don't stop the other jobs.
+   \param job the job to be run with the arguments of each line
+   \param sizeArg the index of the argument naming the file whose size is the
+   size of the job
+   \return the number of failed jobs
+   */
+  int run(Job job, int sizeArg) const;
+
+  /*!
+   \return the number of jobs
+   */
+  inline int size() const { return m_jobs.size(); }
+
+  /*!
+   \param i the job index
+   \return the command line arguments of the job
+   */
+  inline const std::vector<std::string> &args(int i) const {
+    return m_jobs[i];
+  }
+
+  /*!
+   Jobs whose file is at least this size, in bytes, use every thread.
+   */
+  static const long LARGE_JOB_SIZE = 16 * 1024 * 1024;
+
+private:
+  int runJob(Job job, int i) const;
+
+  std::vector<std::vector<std::string> > m_jobs;
+  std::vector<int> m_lines;
+};
+}
+
+#endif
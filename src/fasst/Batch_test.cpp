@@ -0,0 +1,40 @@
+#include "Batch.h"
+#include "gtest/gtest.h"
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+static int g_runs = 0;
+
+static int job(const vector<string> &args, bool verbose) {
+#pragma omp atomic
+  g_runs++;
+  if (verbose || args[0] == "throw") {
+    throw runtime_error("error");
+  }
+  return args[0] == "fail" ? 1 : 0;
+}
+
+TEST(Batch, manifest) {
+  // input: a manifest with comments, empty lines and four jobs
+  // assert: the jobs are read with their arguments, failures are counted
+  ofstream out("tmp_manifest.txt");
+  out << "# comment\n";
+  out << "ok a.wav b.xml\n";
+  out << "\n";
+  out << "  fail\tc.wav  \n";
+  out << "throw\n";
+  out << "ok\n";
+  out.close();
+
+  fasst::Batch batch("tmp_manifest.txt");
+  ASSERT_EQ(4, batch.size());
+  ASSERT_EQ(3u, batch.args(0).size());
+  ASSERT_EQ("b.xml", batch.args(0)[2]);
+  ASSERT_EQ("c.wav", batch.args(1)[1]);
+
+  g_runs = 0;
+  ASSERT_EQ(2, batch.run(&job, 1));
+  ASSERT_EQ(4, g_runs);
+}
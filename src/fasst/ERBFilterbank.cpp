@@ -0,0 +1,81 @@
+#include "ERBFilterbank.h"
+#include <Eigen/Dense>
+#include <cmath>
+#include <map>
+
+using namespace std;
+using namespace Eigen;
+
+namespace fasst {
+
+// round is not available in MSVC so we reimplent it here
+// See: https://stackoverflow.com/questions/19884536/error-c3861-roundf-identifier-not-found
+double round(double x) {
+  return x >= 0. ? floor(x+0.5) : ceil(x-0.5);
+}
+
+const ERBFilterbank &ERBFilterbank::get(int wlen, int bins, double samplerate) {
+  typedef pair<pair<int, int>, double> Key;
+  static map<Key, ERBFilterbank *> cache;
+  Key key(make_pair(wlen, bins), samplerate);
+  ERBFilterbank *filterbank = 0;
+#pragma omp critical(fasst_erbfilterbank)
+  {
+    map<Key, ERBFilterbank *>::iterator it = cache.find(key);
+    if (it == cache.end()) {
+      it = cache.insert(make_pair(key, new ERBFilterbank(wlen, bins,
+                                                         samplerate))).first;
+    }
+    filterbank = it->second;
+  }
+  return *filterbank;
+}
+
+ERBFilterbank::ERBFilterbank(int wlen, int bins, double samplerate) {
+  int F = bins;
+  double fs = samplerate;
+
+  // Determining frequency and window length scales
+  double emax = 9.26 * std::log(0.00437 * fs / 2. + 1.);
+  ArrayXd e = ArrayXd::LinSpaced(F, 0., emax);
+  m_fre = ((e/9.26).exp() - 1.) / 0.00437;
+  m_a = 0.5 * (F-1.) / emax * 9.26 * 0.00437 * fs * (-e/9.26).exp() - .5;
+
+  // Determining dyadic downsampling factors (for fast computation)
+  ArrayXd fup = m_fre + 1.5 * fs / (2 * m_a + 1.);
+  ArrayXd logsubs = (-(2 * fup / fs).log()).min(std::log(wlen/2.));
+  for (int f = 0; f < F; f++) {
+    logsubs(f) = std::floor(logsubs(f) / std::log(2.));
+  }
+  m_subs = (logsubs.max(0) * std::log(2.)).exp();
+  double submax = 1.;
+  double dwlen = wlen / 2.;
+  while (std::floor(dwlen / 2.) == dwlen / 2.) {
+    submax = submax * 2.;
+    dwlen = dwlen / 2.;
+  }
+  m_subs = m_subs.min(submax);
+  m_subs = m_subs.min(512.);
+  for (int f = 0; f < F; f++) {
+    m_subs(f) = fasst::round(m_subs(f));
+  }
+
+  // Determining filterbank and inverse filterbank magnitude response
+  int ngrid = 1000;
+  ArrayXd egrid = ArrayXd::LinSpaced(ngrid, 0., emax);
+  ArrayXd fgrid = ((egrid/9.26).exp() - 1.) / 0.00437;
+  MatrixXd resp(ngrid,F);
+  for (int f = 0; f < F; f++) {
+    int hwlen = fasst::round(m_a(f) / m_subs(f));
+    double alen = (2. * hwlen + 1.) * m_subs(f);
+    ArrayXd r = (fgrid - m_fre(f)) * alen / fs;
+    for (int g = 0; g < ngrid; g++) {
+      if (r(g) == 0) {
+	r(g) = 1e-12;
+      }
+    }
+    resp.col(f) = (Eigen::sin(M_PI*r).cwiseQuotient(M_PI*r) + .5 * Eigen::sin(M_PI*(r+1.)).cwiseQuotient(M_PI*(r+1.)) + .5 * Eigen::sin(M_PI*(r-1.)).cwiseQuotient(M_PI*(r-1.))).pow(2);
+  }
+  m_wei = (resp.adjoint() * resp).inverse() * resp.adjoint() * VectorXd::Ones(ngrid);
+}
+}
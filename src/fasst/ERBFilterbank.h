@@ -0,0 +1,65 @@
+#ifndef FASST_ERBFILTERBANK_H
+#define FASST_ERBFILTERBANK_H
+
+#include <Eigen/Core>
+
+namespace fasst {
+
+/*!
+ Rounds half away from zero, as std::round which MSVC lacks.
+ \param x the value to round
+ \return the nearest integer value
+ */
+double round(double x);
+
+/*!
+ This class contains the parameters of the ERB filterbank used to filter the
+ sources: the center frequency, the length and the dyadic downsampling factor
+ of each band, and the weights of the inverse filterbank. The weights are the
+ least-squares solution of a system sampled on a fine frequency grid, which is
+ costly, so the filterbank is computed once per set of parameters and shared
+ by every transform.
+ */
+class ERBFilterbank {
+public:
+  /*!
+   This method gives access to the filterbank of some parameters. It is
+   computed the first time it is needed and then kept in a cache.
+   \param wlen the window length
+   \param bins the number of frequency bins
+   \param samplerate the samplerate
+   \return the filterbank corresponding to the parameters
+   */
+  static const ERBFilterbank &get(int wlen, int bins, double samplerate);
+
+  /*!
+   \return the center frequency of each band
+   */
+  inline const Eigen::ArrayXd &fre() const { return m_fre; }
+
+  /*!
+   \return the half length of the filter of each band, before downsampling
+   */
+  inline const Eigen::ArrayXd &a() const { return m_a; }
+
+  /*!
+   \return the dyadic downsampling factor of each band
+   */
+  inline const Eigen::ArrayXd &subs() const { return m_subs; }
+
+  /*!
+   \return the weight of each band in the inverse filterbank
+   */
+  inline const Eigen::ArrayXd &wei() const { return m_wei; }
+
+private:
+  ERBFilterbank(int wlen, int bins, double samplerate);
+
+  Eigen::ArrayXd m_fre;
+  Eigen::ArrayXd m_a;
+  Eigen::ArrayXd m_subs;
+  Eigen::ArrayXd m_wei;
+};
+}
+
+#endif
@@ -1,6 +1,11 @@
 #include "ERBRepr.h"
 #include "Audio.h"
+#include "ERBFilterbank.h"
+#include "FFTPlans.h"
+#include "Framing.h"
 #include "Sources.h"
+#include "SourceSink.h"
+#include <algorithm>
 #include <stdexcept>
 #include <unsupported/Eigen/FFT>
 #include <unsupported/Eigen/MatrixFunctions>
@@ -10,11 +15,10 @@ using namespace std;
 
 namespace fasst {
 
-// round is not available in MSVC so we reimplent it here
-// See: https://stackoverflow.com/questions/19884536/error-c3861-roundf-identifier-not-found
-double round(double x) {
-  return x >= 0. ? floor(x+0.5) : ceil(x-0.5);
-}
+// Half lengths of the lowpass filters of downsample and upsample, in samples
+// at the higher of the two sampling rates
+static const int DOWNSAMPLE_HALF_LENGTH = 100;
+static const int UPSAMPLE_HALF_LENGTH = 50;
 
 ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
   int samples = x.samples();
@@ -30,39 +34,23 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     throw runtime_error(s.str());
   }
 
-  // Determining frequency and window length scales
-  double emax = 9.26 * std::log(0.00437 * fs / 2. + 1.);
-  ArrayXd e = ArrayXd::LinSpaced(F, 0., emax);
-  ArrayXd fre = ((e/9.26).exp() - 1.) / 0.00437;
-  ArrayXd a = 0.5 * (F-1.) / emax * 9.26 * 0.00437 * fs * (-e/9.26).exp() - .5;
-
-  // Determining dyadic downsampling factors (for fast computation)
-  ArrayXd fup = fre + 1.5 * fs / (2 * a + 1.);
-  ArrayXd logsubs = (-(2 * fup / fs).log()).min(std::log(wlen/2.));
-  for (int f = 0; f < F; f++) {
-    logsubs(f) = std::floor(logsubs(f) / std::log(2.));
-  }
-  ArrayXd subs = (logsubs.max(0) * std::log(2.)).exp();
-  double submax = 1.;
-  double dwlen = wlen / 2.;
-  while (std::floor(dwlen / 2.) == dwlen / 2.) {
-    submax = submax * 2.;
-    dwlen = dwlen / 2.;
-  }
-  subs = subs.min(submax);
-  for (int f = 0; f < F; f++) {
-    subs(f) = round(subs(f));
-  }
+  // Frequency scale, band lengths and downsampling factors, shared with the
+  // filtering
+  const ERBFilterbank &filterbank = ERBFilterbank::get(wlen, F, fs);
+  const ArrayXd &fre = filterbank.fre();
+  const ArrayXd &a = filterbank.a();
+  const ArrayXd &subs = filterbank.subs();
   ArrayXd subs_shift(F);
   subs_shift.segment(0, F-1) = subs.tail(F-1);
   subs_shift(F-1) = 1.;
 
-  // Defining sine window
-  ArrayXd win = Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
+  // Sine window and normalisation for edges
+  const Framing *framing = &Framing::get(wlen);
 
   // Zero-padding and Hilbert transform
-  int N = static_cast<int>(ceil(static_cast<double>(samples) / wlen * 2));
+  int N = static_cast<int>(std::ceil(static_cast<double>(samples) / wlen * 2));
   ArrayXXcd xx((N + 1) * wlen / 2, I);
+  // Its length is that of the signal, so its plan isn't kept in FFTPlans
   FFT<double> fft;
   for (int i = 0; i < I; i++) {
     VectorXd xchan = VectorXd::Zero((N + 1) * wlen / 2);
@@ -77,13 +65,6 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     xx.col(i) = xxchan;
   }
 
-  // Pre-processing for edges
-  ArrayXd swin = ArrayXd::Zero((N + 1) * wlen / 2);
-  for (int n = 0; n < N; n++) {
-    swin.segment(n * wlen / 2, wlen) += (win * win);
-  }
-  swin = Eigen::sqrt(swin);
-
   // Loop over frequency bins
   _set(ArrayMatrixXcd(F, N));
   for (int f = F - 1; f >= 0; f--) {
@@ -92,16 +73,11 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     if (subs(f) != subs_shift(f)) {
       xx = downsample(xx);
       wlen = wlen / 2;
-      win = Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
-      swin = ArrayXd::Zero((N + 1) * wlen / 2);
-      for (int n = 0; n < N; n++) {
-        swin.segment(n * wlen / 2, wlen) += (win * win);
-      }
-      swin = Eigen::sqrt(swin);
+      framing = &Framing::get(wlen);
     }
 
     // Bandpass filter
-    int hwlen = round(a(f) / subs(f));
+    int hwlen = fasst::round(a(f) / subs(f));
     ArrayXd hann = 0.5 - Eigen::cos(ArrayXd::LinSpaced(2 * hwlen + 1, 1., 2. * hwlen + 1.) / (hwlen + 1.) * M_PI) * 0.5;
     ArrayXcd h = Eigen::exp(ArrayXd::LinSpaced(2 * hwlen + 1, -hwlen, hwlen) * 2 * M_I * M_PI * fre(f) / fs * subs(f)) * hann;
     ArrayXXcd xxband = fftfilt(h, xx);
@@ -110,28 +86,26 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     for (int n = 0; n < N; n++) {
       MatrixXcd xxfram(wlen, I);
       for (int i = 0; i < I; i++) {
-        xxfram.col(i) = xxband.block(n * wlen / 2, i, wlen, 1) * win / swin.segment(n * wlen / 2, wlen);
+        xxfram.col(i) = xxband.block(n * wlen / 2, i, wlen, 1) * framing->weights(n, N);
       }
       (*this)(f, n) = (xxfram.adjoint() * xxfram).conjugate() * subs(f) / std::pow(hwlen + 1., 2.);
     }
   }
 }
 
-  std::vector<Audio> ERBRepr::FilterERB(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse) {
+std::vector<Audio> ERBRepr::FilterERB(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse) {
+  SourceCollector collector(srcs.size(), x.samples(), x.samplerate());
+  FilterERB(x, wlen, srcs, Sigma_x_inverse, collector, 0);
+  return collector.output();
+}
+
+void ERBRepr::FilterERB(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse, SourceSink &sink, int blockFrames) {
 
   int samples = x.samples();
   double fs = x.samplerate();
-  int I = x.channels();
   int J = srcs.size();
   int F = srcs[0].bins();
-  const std::complex<double> M_I(0, 1);
-  ArrayXd ranks(J + 1);
-  ranks(0) = 0;
-  for (int j = 0; j < J; j++) {
-    ranks(j + 1) = srcs[j].rank();
-  }
-  int R = ranks.sum();
-  
+
   // Checking window length
   if (wlen % 2 != 0 || wlen == 0) {
     stringstream s;
@@ -139,57 +113,15 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     throw runtime_error(s.str());
   }
 
-  // Determining frequency and window length scales
-  double emax = 9.26 * std::log(0.00437 * fs / 2. + 1.);
-  ArrayXd e = ArrayXd::LinSpaced(F, 0., emax);
-  ArrayXd fre = ((e/9.26).exp() - 1.) / 0.00437;
-  ArrayXd a = 0.5 * (F-1.) / emax * 9.26 * 0.00437 * fs * (-e/9.26).exp() - .5;
-  
-  // Determining dyadic downsampling factors (for fast computation)
-  ArrayXd fup = fre + 1.5 * fs / (2 * a + 1.);
-  ArrayXd logsubs = (-(2 * fup / fs).log()).min(std::log(wlen/2.));
-  for (int f = 0; f < F; f++) {
-    logsubs(f) = std::floor(logsubs(f) / std::log(2.));
-  }
-  ArrayXd subs = (logsubs.max(0) * std::log(2.)).exp();
-  double submax = 1.;
-  double dwlen = wlen / 2.;
-  while (std::floor(dwlen / 2.) == dwlen / 2.) {
-    submax = submax * 2.;
-    dwlen = dwlen / 2.;
-  }
-  subs = subs.min(submax);
-  subs = subs.min(512.);
-  for (int f = 0; f < F; f++) {
-    subs(f) = round(subs(f));
-  }
-  ArrayXd subs_shift(F);
-  subs_shift.segment(0, F-1) = subs.tail(F-1);
-  subs_shift(F-1) = 1.;
-
-  // Determining filterbank and inverse filterbank magnitude response
-  int ngrid = 1000;
-  ArrayXd egrid = ArrayXd::LinSpaced(ngrid, 0., emax);
-  ArrayXd fgrid = ((egrid/9.26).exp() - 1.) / 0.00437;
-  MatrixXd resp(ngrid,F);
-  for (int f = 0; f < F; f++) {
-    int hwlen = round(a(f) / subs(f));
-    double alen = (2. * hwlen + 1.) * subs(f);
-    ArrayXd r = (fgrid - fre(f)) * alen / fs;
-    for (int g = 0; g < ngrid; g++) {
-      if (r(g) == 0) {
-	r(g) = 1e-12;
-      }
-    }
-    resp.col(f) = (Eigen::sin(M_PI*r).cwiseQuotient(M_PI*r) + .5 * Eigen::sin(M_PI*(r+1.)).cwiseQuotient(M_PI*(r+1.)) + .5 * Eigen::sin(M_PI*(r-1.)).cwiseQuotient(M_PI*(r-1.))).pow(2);
-  }
-  ArrayXd wei = (resp.adjoint() * resp).inverse() * resp.adjoint() * VectorXd::Ones(ngrid);
-
-  // Defining sine window
-  ArrayXd win = Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
+  // Filterbank and inverse filterbank, shared by every transform
+  const ERBFilterbank &filterbank = ERBFilterbank::get(wlen, F, fs);
+  const ArrayXd &fre = filterbank.fre();
+  const ArrayXd &a = filterbank.a();
+  const ArrayXd &subs = filterbank.subs();
+  const ArrayXd &wei = filterbank.wei();
 
   // Checking if dimensions are consistent
-  int N = static_cast<int>(ceil(static_cast<double>(samples) / wlen * 2));
+  int N = static_cast<int>(std::ceil(static_cast<double>(samples) / wlen * 2));
   if (N != srcs[0].frames()) {
     stringstream s;
     s << "Error:\tnumber of frames is not consistent:\n";
@@ -198,15 +130,88 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     throw runtime_error(s.str());
   }
 
+  // Determining the context needed on each side of a block so that it covers
+  // the tails of the resampling filters, of the analysis and synthesis
+  // filterbanks and of the time integration
+  int hop = wlen / 2;
+  int bandTail = 0;
+  for (int f = 0; f < F; f++) {
+    bandTail = std::max(bandTail, static_cast<int>(fasst::round(a(f) / subs(f)) * subs(f)));
+  }
+  // A chain of dyadic downsamplings by subs spreads a sample over less than
+  // DOWNSAMPLE_HALF_LENGTH * subs input samples on each side, and upsampling
+  // by subs over UPSAMPLE_HALF_LENGTH * subs output samples
+  int resamplingTail = (DOWNSAMPLE_HALF_LENGTH + UPSAMPLE_HALF_LENGTH) *
+                       static_cast<int>(subs.maxCoeff());
+  int tail = resamplingTail + 2 * bandTail + 2 * wlen;
+  int context = static_cast<int>(std::ceil(static_cast<double>(tail) / hop));
+  if (blockFrames <= 0) {
+    blockFrames = 8 * context;
+  }
+
+  // Loop over time blocks: each block is computed from a segment of the
+  // zero-padded mixture which is extended by the context on each side, and
+  // only the central part of the result is kept
+  int length = (N + 1) * hop;
+  for (int first = 0; first * hop < samples; first += blockFrames) {
+    int begin = first * hop;
+    int end = std::min(begin + blockFrames * hop, samples);
+    int segBegin = std::max(0, first - context) * hop;
+    int segEnd = std::min(length, (first + blockFrames + context) * hop);
+
+    ArrayXXd yy = filterBlock(x, segBegin, segEnd, wlen, N, fre, a, subs, wei,
+                              srcs, Sigma_x_inverse);
+
+    // Seeing output as audio
+    vector<ArrayXXd> y(J);
+    int rankpos = 0;
+    for (int j = 0; j < J; j++) {
+      y[j] = yy.block(begin - segBegin, rankpos, end - begin, srcs[j].rank());
+      rankpos += srcs[j].rank();
+    }
+    sink.write(y);
+  }
+}
+
+Eigen::ArrayXXd ERBRepr::filterBlock(const Audio &x, int segBegin, int segEnd, int wlen, int N, const Eigen::ArrayXd &fre, const Eigen::ArrayXd &a, const Eigen::ArrayXd &subs, const Eigen::ArrayXd &wei, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse) {
+  int samples = x.samples();
+  double fs = x.samplerate();
+  int I = x.channels();
+  int J = srcs.size();
+  int F = fre.size();
+  const std::complex<double> M_I(0, 1);
+  ArrayXd ranks(J + 1);
+  ranks(0) = 0;
+  for (int j = 0; j < J; j++) {
+    ranks(j + 1) = srcs[j].rank();
+  }
+  int R = ranks.sum();
+  ArrayXd subs_shift(F);
+  subs_shift.segment(0, F-1) = subs.tail(F-1);
+  subs_shift(F-1) = 1.;
+
+  // Time frames lying entirely inside the segment
+  int length = segEnd - segBegin;
+  int nfirst = segBegin / (wlen / 2);
+  int nlast = std::min(N, (segEnd - wlen) / (wlen / 2) + 1);
+  int M = nlast - nfirst;
+
+  // Sine window and normalisation for edges
+  const Framing *framing = &Framing::get(wlen);
+
   // Zero-padding and Hilbert transform
-  ArrayXXcd xx((N + 1) * wlen / 2, I);
+  ArrayXXcd xx(length, I);
+  // Its length is that of the segment, so its plan isn't kept in FFTPlans
   FFT<double> fft;
   for (int i = 0; i < I; i++) {
-    VectorXd xchan = VectorXd::Zero((N + 1) * wlen / 2);
-    xchan.head(samples) = x.col(i);
+    VectorXd xchan = VectorXd::Zero(length);
+    if (segBegin < samples) {
+      int count = std::min(segEnd, samples) - segBegin;
+      xchan.head(count) = x.block(segBegin, i, count, 1);
+    }
     VectorXcd fchan;
     fft.fwd(fchan, xchan);
-    int index = std::ceil((N+1) * wlen/4.) - 1;
+    int index = std::ceil(length / 2.) - 1;
     fchan.segment(1, index) = 2. * fchan.segment(1, index);
     fchan.tail(index) = VectorXcd::Zero(index);
     VectorXcd xxchan;
@@ -214,17 +219,11 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     xx.col(i) = xxchan;
   }
 
-  // Pre-processing for edges
-  ArrayXd swin = ArrayXd::Zero((N + 1) * wlen / 2);
-  for (int n = 0; n < N; n++) {
-    swin.segment(n * wlen / 2, wlen) += (win * win);
-  }
-  swin = Eigen::sqrt(swin);
-
   // Initialize source signals
-  ArrayXXd yy = ArrayXXd::Zero((N + 1) * wlen / 2, R);
-  ArrayXXcd yyscale = ArrayXXcd::Zero((N + 1) * wlen / 2, R);
-  
+  ArrayXXd yy = ArrayXXd::Zero(length, R);
+  ArrayXXcd yyscale = ArrayXXcd::Zero(length, R);
+  MatrixXcd gains(I, M * R);
+
   // Loop over frequency bins
   for (int f = F - 1; f >= 0; f--) {
 
@@ -232,33 +231,46 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     if (subs(f) != subs_shift(f)) {
       xx = downsample(xx);
       wlen = wlen / 2;
-      win = Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
-      swin = ArrayXd::Zero((N + 1) * wlen / 2);
-      for (int n = 0; n < N; n++) {
-        swin.segment(n * wlen / 2, wlen) += (win * win);
-      }
-      swin = Eigen::sqrt(swin);
+      length = length / 2;
+      framing = &Framing::get(wlen);
       yy += upsample(yyscale, subs(f+1)).real();
-      yyscale = ArrayXXcd::Zero((N + 1) * wlen / 2, R);
+      yyscale = ArrayXXcd::Zero(length, R);
     }
 
     // Filterbank
-    int hwlen = round(a(f) / subs(f));
+    int hwlen = fasst::round(a(f) / subs(f));
     ArrayXd hann = 0.5 - Eigen::cos(ArrayXd::LinSpaced(2 * hwlen + 1, 1., 2. * hwlen + 1.) / (hwlen + 1.) * M_PI) * 0.5;
     ArrayXcd h = Eigen::exp(ArrayXd::LinSpaced(2 * hwlen + 1, -hwlen, hwlen) * 2 * M_I * M_PI * fre(f) / fs * subs(f)) * hann / (hwlen + 1.);
     ArrayXXcd xxband = fftfilt(h, xx);
 
-    // Bandwise filtering
-    ArrayXXcd yyband = ArrayXXcd::Zero((N + 1) * wlen / 2, R);
-    for (int j = 0; j < J; j++) {
-      int rankpos = (ranks.segment(0, j+1)).sum();
-      for (int n = 0; n < N; n++) {
-	MatrixXcd xxfram(wlen, I);
-	for (int i = 0; i < I; i++) {
-	  xxfram.col(i) = xxband.block(n * wlen / 2, i, wlen, 1) * (win / swin.segment(n * wlen / 2, wlen)).pow(2);
-	}
-	MatrixXcd W = srcs[j].WienerFilter(f,n,Sigma_x_inverse(f, n));
-	yyband.block(n * wlen / 2, rankpos, wlen, ranks(j+1)) += (xxfram * W.transpose()).array();
+    // Wiener gains of every source at every frame of the band, stored
+    // transposed side by side so that one product filters all sources
+    #pragma omp parallel for
+    for (int m = 0; m < M; m++) {
+      int n = nfirst + m;
+      for (int j = 0; j < J; j++) {
+        int rankpos = (ranks.segment(0, j+1)).sum();
+        if (srcs[j].wiener_qd() > 0) {
+          gains.block(0, m * R + rankpos, I, ranks(j+1)) = srcs[j].WienerFilter(f, n, Sigma_x_inverse(f, n)).transpose();
+        } else {
+          gains.block(0, m * R + rankpos, I, ranks(j+1)).noalias() = Sigma_x_inverse(f, n).transpose() * srcs[j].Sigma_y(f, n).transpose();
+        }
+      }
+    }
+
+    // Bandwise filtering: overlapping frames have a different parity, so
+    // the frames of one parity can be accumulated in parallel
+    ArrayXXcd yyband = ArrayXXcd::Zero(length, R);
+    for (int parity = 0; parity < 2; parity++) {
+      #pragma omp parallel
+      {
+        MatrixXcd xxfram(wlen, I);
+        #pragma omp for
+        for (int m = parity; m < M; m += 2) {
+          const ArrayXd &wei2 = framing->squaredWeights(nfirst + m, N);
+          xxfram.noalias() = wei2.matrix().asDiagonal() * xxband.block(m * wlen / 2, 0, wlen, I).matrix();
+          yyband.block(m * wlen / 2, 0, wlen, R).matrix().noalias() += xxfram * gains.middleCols(m * R, R);
+        }
       }
     }
 
@@ -266,15 +278,7 @@ ERBRepr::ERBRepr(const Audio &x, int wlen, int nbin) {
     yyscale += wei(f) * fftfilt(h, yyband);
   }
   yy += upsample(yyscale, subs(0)).real();
- 
-  // Seeing output as audio
-  vector<Audio> output(J);
-  for (int j = 0; j < J; j++) {
-    int rankpos = (ranks.segment(0, j+1)).sum();
-    ArrayXXd y = yy.block(0, rankpos, samples, ranks(j+1));
-    output[j] = Audio(y);
-  }
-  return output;
+  return yy;
 }
 
 Eigen::ArrayXXcd ERBRepr::fftfilt(Eigen::ArrayXcd h, Eigen::ArrayXXcd x) {
@@ -294,7 +298,7 @@ Eigen::ArrayXXcd ERBRepr::fftfilt(Eigen::ArrayXcd h, Eigen::ArrayXXcd x) {
   
   // Zero-padding and FFT
   ArrayXXcd y(samples, I);
-  FFT<double> fft;
+  FFT<double> &fft = FFTPlans::get();
   VectorXcd hpad = VectorXcd::Zero(nfft);
   hpad.head(L) = h;
   VectorXcd fhpad;
@@ -321,11 +325,11 @@ Eigen::ArrayXXcd ERBRepr::downsample(Eigen::ArrayXXcd x) {
   // Lowpass filter
   ArrayXd coeff(50);
   coeff << -0.000133178150, 0.000169248200, -0.000210182991, 0.000256357557, -0.000308162910, 0.000366006936, -0.000430315500, 0.000501533833, -0.000580128236, 0.000666588166, -0.000761428788, 0.000865194071, -0.000978460543, 0.001101841829, -0.001235994132, 0.001381622851, -0.001539490568, 0.001710426705, -0.001895339216, 0.002095228768, -0.002311206013, 0.002544512690, -0.002796547517, 0.003068898145, -0.003363380811, 0.003682089868, -0.004027460137, 0.004402346030, -0.004810122891, 0.005254818118, -0.005741282722, 0.006275418606, -0.006864483808, 0.007517508754, -0.008245873624, 0.009064124553, -0.009991152491, 0.011051937730, -0.012280204408, 0.013722591565, -0.015445458153, 0.017546491099, -0.020175599200, 0.023575092892, -0.028163695506, 0.034732568224, -0.044977376046, 0.063307309465, -0.105890188403, 0.318238799405;
-  ArrayXcd h = ArrayXcd::Zero(201);
-  h(100) = 0.5;
-  for (int t = 0; t < 50; t++) {
+  ArrayXcd h = ArrayXcd::Zero(2 * DOWNSAMPLE_HALF_LENGTH + 1);
+  h(DOWNSAMPLE_HALF_LENGTH) = 0.5;
+  for (int t = 0; t < DOWNSAMPLE_HALF_LENGTH / 2; t++) {
     h(2 * t + 1) = coeff(t);
-    h(199 - 2 * t) = coeff(t);
+    h(2 * DOWNSAMPLE_HALF_LENGTH - 1 - 2 * t) = coeff(t);
   }
   
   // Filtering
@@ -347,11 +351,11 @@ Eigen::ArrayXXcd ERBRepr::upsample(Eigen::ArrayXXcd x, int factor) {
   #include "lowpass.h"
 
   // Lowpass filter
-  ArrayXcd h = ArrayXcd::Zero(100 * factor + 1);
-  h(50 * factor) = 1.;
-  for (int t = 0; t < 50 * factor; t++) {
+  ArrayXcd h = ArrayXcd::Zero(2 * UPSAMPLE_HALF_LENGTH * factor + 1);
+  h(UPSAMPLE_HALF_LENGTH * factor) = 1.;
+  for (int t = 0; t < UPSAMPLE_HALF_LENGTH * factor; t++) {
     h(t) = coeff[t * 512 / factor];
-    h(100 * factor - t) = coeff[t * 512 / factor];
+    h(2 * UPSAMPLE_HALF_LENGTH * factor - t) = coeff[t * 512 / factor];
   }
 
   // Upsampling
@@ -6,6 +6,7 @@
 namespace fasst {
 class Audio;
 class Source;
+class SourceSink;
 
 /*!
  This class contains a mixture covariance matrix. The data is stored in an
@@ -47,6 +48,22 @@ public:
    */
   static std::vector<Audio> FilterERB(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse);
 
+  /*!
+   This method applies the Wiener filter in the ERB domain block by block. Each
+   block of time frames is computed from a segment of the mixture extended on
+   both sides by the tails of the filters, so that the memory used does not
+   depend on the length of the signal. The audio signal of each source is
+   given to the sink as soon as a block is done.
+   \param x the mixture audio signal
+   \param wlen the window length
+   \param srcs the sources structure
+   \param Sigma_x_inverse the inverse of the model covariance matrix
+   \param sink the consumer of the audio signal of each source
+   \param blockFrames the number of time frames per block, or 0 to choose it
+   from the length of the filter tails
+   */
+  static void FilterERB(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse, SourceSink &sink, int blockFrames);
+
   /*!
    Filters a signal using FFT-based convolution.
    \param h a complex-valued filter with odd length
@@ -57,6 +74,24 @@ public:
   static Eigen::ArrayXXcd fftfilt(Eigen::ArrayXcd h, Eigen::ArrayXXcd x);
 
 private:
+  /*!
+   Applies the Wiener filter in the ERB domain to a segment of the zero-padded
+   mixture.
+   \param x the mixture audio signal
+   \param segBegin the first sample of the segment, at a frame boundary
+   \param segEnd the sample following the segment, at a frame boundary
+   \param wlen the window length
+   \param N the number of time frames of the whole signal
+   \param fre the center frequency of each band
+   \param a the half length of the filter of each band
+   \param subs the downsampling factor of each band
+   \param wei the weight of each band in the inverse filterbank
+   \param srcs the sources structure
+   \param Sigma_x_inverse the inverse of the model covariance matrix
+   \return the rank-wise source signals over the segment
+   */
+  static Eigen::ArrayXXd filterBlock(const Audio &x, int segBegin, int segEnd, int wlen, int N, const Eigen::ArrayXd &fre, const Eigen::ArrayXd &a, const Eigen::ArrayXd &subs, const Eigen::ArrayXd &wei, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse);
+
   /*!
    Downsamples a signal by a factor of 2.
    \param x a complex-valued multichannel signal
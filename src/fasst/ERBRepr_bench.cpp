@@ -0,0 +1,65 @@
+#include "ERBRepr.h"
+#include "bench.h"
+#include <benchmark/benchmark.h>
+
+using namespace fasst;
+
+// Ten seconds of audio at 16 kHz
+static const int SAMPLES = 160000;
+
+// Sweeps the number of channels, the window length and the number of bins
+static void channelsWindowsAndBins(benchmark::internal::Benchmark *b) {
+  for (int I = 1; I <= 2; I *= 2) {
+    for (int wlen = 512; wlen <= 1024; wlen *= 2) {
+      for (int F = 32; F <= 128; F *= 2) {
+        b->Args({I, wlen, F});
+      }
+    }
+  }
+}
+
+static void ERBRepr_analysis(benchmark::State &state) {
+  Audio x = benchAudio(SAMPLES, state.range(0));
+  int wlen = state.range(1);
+  int F = state.range(2);
+  while (state.KeepRunning()) {
+    ERBRepr X(x, wlen, F);
+    benchmark::DoNotOptimize(X.data());
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLES);
+}
+BENCHMARK(ERBRepr_analysis)->Apply(channelsWindowsAndBins);
+
+// Sweeps the number of channels, the filter length and the signal length
+static void channelsFiltersAndSamples(benchmark::internal::Benchmark *b) {
+  for (int I = 1; I <= 4; I *= 2) {
+    for (int taps = 255; taps <= 4095; taps = taps * 4 + 3) {
+      for (int samples = 16384; samples <= 262144; samples *= 4) {
+        b->Args({I, taps, samples});
+      }
+    }
+  }
+}
+
+static void ERBRepr_fftfilt(benchmark::State &state) {
+  int I = state.range(0);
+  int taps = state.range(1);
+  int samples = state.range(2);
+  unsigned seed = 1;
+  Eigen::ArrayXcd h(taps);
+  for (int k = 0; k < taps; k++) {
+    h(k) = std::complex<double>(benchRandom(seed), benchRandom(seed));
+  }
+  Eigen::ArrayXXcd x(samples, I);
+  for (int i = 0; i < I; i++) {
+    for (int n = 0; n < samples; n++) {
+      x(n, i) = std::complex<double>(benchRandom(seed), benchRandom(seed));
+    }
+  }
+  while (state.KeepRunning()) {
+    Eigen::ArrayXXcd y = ERBRepr::fftfilt(h, x);
+    benchmark::DoNotOptimize(y.data());
+  }
+  state.SetItemsProcessed(state.iterations() * samples * I);
+}
+BENCHMARK(ERBRepr_fftfilt)->Apply(channelsFiltersAndSamples);
@@ -0,0 +1,18 @@
+#include "FFTPlans.h"
+
+using namespace Eigen;
+
+namespace fasst {
+
+// Each thread has its own pointer, which is POD so that it can be
+// threadprivate with every OpenMP implementation
+static FFT<double> *s_fft = 0;
+#pragma omp threadprivate(s_fft)
+
+FFT<double> &FFTPlans::get() {
+  if (s_fft == 0) {
+    s_fft = new FFT<double>;
+  }
+  return *s_fft;
+}
+}
@@ -0,0 +1,29 @@
+#ifndef FASST_FFTPLANS_H
+#define FASST_FFTPLANS_H
+
+#include <unsupported/Eigen/FFT>
+
+namespace fasst {
+
+/*!
+ This class gives each thread its own Eigen FFT object. An FFT object keeps the
+ plans (factorisations and twiddle factors) of the sizes it has already
+ transformed, so they are computed once per thread instead of once per
+ transform, and are reused from one file to the next in batch mode.
+
+ \remark Only transforms with a small set of sizes, such as the frames of a
+ STFT or the power-of-two blocks of ERBRepr::fftfilt, should use it: the plans
+ are never released. The Hilbert transforms of the ERB transforms have the
+ length of the signal or of a segment, so they use local FFT objects, whose
+ plans are released with them.
+ */
+class FFTPlans {
+public:
+  /*!
+   \return the FFT object of the calling thread
+   */
+  static Eigen::FFT<double> &get();
+};
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "Framing.h"
+#include <map>
+
+using namespace std;
+using namespace Eigen;
+
+namespace fasst {
+const Framing &Framing::get(int wlen) {
+  static map<int, Framing *> cache;
+  Framing *framing = 0;
+#pragma omp critical(fasst_framing)
+  {
+    map<int, Framing *>::iterator it = cache.find(wlen);
+    if (it == cache.end()) {
+      it = cache.insert(make_pair(wlen, new Framing(wlen))).first;
+    }
+    framing = it->second;
+  }
+  return *framing;
+}
+
+Framing::Framing(int wlen) {
+  int hop = wlen / 2;
+
+  // Defining sine window
+  m_window = Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
+  ArrayXd win2 = m_window * m_window;
+
+  // Sum of the squared windows over one frame: the first half of a frame is
+  // overlapped by the previous frame and the second half by the next one
+  ArrayXd prev = ArrayXd::Zero(wlen);
+  prev.head(hop) = win2.tail(hop);
+  ArrayXd next = ArrayXd::Zero(wlen);
+  next.tail(hop) = win2.head(hop);
+
+  ArrayXd swin[4];
+  swin[0] = (prev + win2) + next;
+  swin[1] = win2 + next;
+  swin[2] = prev + win2;
+  swin[3] = win2;
+
+  for (int k = 0; k < 4; k++) {
+    m_weights[k] = m_window / Eigen::sqrt(swin[k]);
+    m_squaredWeights[k] = m_weights[k] * m_weights[k];
+  }
+}
+}
@@ -0,0 +1,78 @@
+#ifndef FASST_FRAMING_H
+#define FASST_FRAMING_H
+
+#include <Eigen/Core>
+
+namespace fasst {
+
+/*!
+ This class contains the sine window used to cut a signal into time frames
+ which overlap by half of their length, together with the weights used to
+ normalise the overlap-add of the frames. Only the first and the last frames
+ of a signal have a special weight: every other frame has the same one, so the
+ weights are computed once per window length and shared by every transform.
+ */
+class Framing {
+public:
+  /*!
+   This method gives access to the framing of a given window length. It is
+   computed the first time it is needed and then kept in a cache.
+   \param wlen the window length
+   \return the framing corresponding to the window length
+   */
+  static const Framing &get(int wlen);
+
+  /*!
+   \return the sine window
+   */
+  inline const Eigen::ArrayXd &window() const { return m_window; }
+
+  /*!
+   This method gives the window of one frame divided by the square root of the
+   sum of the squared windows of all frames, so that the overlap-add of the
+   squared weights of all frames is equal to one.
+   \param frame the time frame index
+   \param frames the number of time frames
+   \return the weights of the frame
+   */
+  inline const Eigen::ArrayXd &weights(int frame, int frames) const {
+    return m_weights[kind(frame, frames)];
+  }
+
+  /*!
+   This method gives the product of the analysis and synthesis weights of one
+   frame, _ie._ the square of Framing::weights.
+   \param frame the time frame index
+   \param frames the number of time frames
+   \return the squared weights of the frame
+   */
+  inline const Eigen::ArrayXd &squaredWeights(int frame, int frames) const {
+    return m_squaredWeights[kind(frame, frames)];
+  }
+
+private:
+  Framing(int wlen);
+
+  /*!
+   \return 0 for an interior frame, 1 for the first frame, 2 for the last frame
+   and 3 if the frame is the only one
+   */
+  inline static int kind(int frame, int frames) {
+    if (frames == 1) {
+      return 3;
+    } else if (frame == 0) {
+      return 1;
+    } else if (frame == frames - 1) {
+      return 2;
+    } else {
+      return 0;
+    }
+  }
+
+  Eigen::ArrayXd m_window;
+  Eigen::ArrayXd m_weights[4];
+  Eigen::ArrayXd m_squaredWeights[4];
+};
+}
+
+#endif
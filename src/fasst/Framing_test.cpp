@@ -0,0 +1,34 @@
+#include "Framing.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace Eigen;
+
+TEST(Framing, overlapAddIsOne) {
+  // input: wlen=8, N=5 frames
+  // assert: overlap-add of the squared weights is one everywhere
+  int wlen = 8;
+  int N = 5;
+  const fasst::Framing &framing = fasst::Framing::get(wlen);
+  ArrayXd sum = ArrayXd::Zero((N + 1) * wlen / 2);
+  for (int n = 0; n < N; n++) {
+    sum.segment(n * wlen / 2, wlen) += framing.squaredWeights(n, N);
+  }
+  for (int t = 0; t < sum.size(); t++) {
+    ASSERT_NEAR(sum(t), 1., 1e-12);
+  }
+}
+
+TEST(Framing, singleFrame) {
+  // input: wlen=8, N=1 frame
+  // assert: the weights of the only frame are all ones
+  const fasst::Framing &framing = fasst::Framing::get(8);
+  for (int t = 0; t < 8; t++) {
+    ASSERT_DOUBLE_EQ(framing.weights(0, 1)(t), 1.);
+  }
+}
+
+TEST(Framing, isCached) {
+  // assert: the same window length gives the same object
+  ASSERT_EQ(&fasst::Framing::get(16), &fasst::Framing::get(16));
+}
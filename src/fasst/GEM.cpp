@@ -0,0 +1,78 @@
+#include "GEM.h"
+#include "Sources.h"
+#include "MixCovMatrix.h"
+#include "NaturalStatistics.h"
+#include "Profiler.h"
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace Eigen;
+
+namespace fasst {
+GEM::GEM(Sources &sources, const MixCovMatrix &hatRx, int iterations)
+    : m_sources(sources), m_hatRx(hatRx), m_iteration(0),
+      m_iterations(iterations) {
+  int F = hatRx.bins();
+  int N = hatRx.frames();
+  int I = hatRx.channels();
+
+  // Check if dimensions are consistent
+  if (F != sources.bins() || N != sources.frames() ||
+      I != sources.channels()) {
+    stringstream s;
+    s << "Error:\tdimensions are not consistent:\n";
+    s << "F = " << F << ", N = " << N << ", I = " << I << " in Rx\n";
+    s << "F = " << sources.bins() << ", N = " << sources.frames()
+      << ", I = " << sources.channels() << " in sources\n";
+    throw runtime_error(s.str());
+  }
+
+  // Compute additive noise
+  VectorXd noise = VectorXd::Zero(F);
+  for (int f = 0; f < F; f++) {
+    for (int n = 0; n < N; n++) {
+      noise(f) += (hatRx(f, n).real().trace() / I);
+    }
+    noise(f) /= N;
+  }
+  m_noiseBeg = noise / 100;
+  m_noiseEnd = noise / 10000;
+}
+
+double GEM::next() { return next(m_sources, m_hatRx); }
+
+double GEM::next(Sources &sources, const MixCovMatrix &hatRx) {
+  // Conditional expectation of the natural statistics and log-likelihood
+  ScopedTimer estep("estep");
+  NaturalStatistics stats(sources, hatRx, noise(m_iteration));
+  estep.stop();
+
+  // Update A
+  {
+    ScopedTimer mixing("mixing");
+    sources.updateMixingParameter(stats);
+  }
+
+  // Update V
+  sources.updateSpectralPower(stats);
+
+  m_iteration++;
+  Profiler::get().iteration(stats.logLikelihood());
+  return stats.logLikelihood();
+}
+
+VectorMatrixXcd GEM::noise(int iteration) const {
+  int F = m_noiseBeg.size();
+  int I = m_hatRx.channels();
+
+  // Compute Sigma_b
+  VectorMatrixXcd Sigma_b(F);
+  for (int f = 0; f < F; f++) {
+    double sigma_f = (sqrt(m_noiseBeg(f)) * (m_iterations - iteration - 1) +
+                      sqrt(m_noiseEnd(f)) * (iteration + 1)) / m_iterations;
+    Sigma_b(f) = MatrixXcd::Identity(I, I) * sigma_f * sigma_f;
+  }
+  return Sigma_b;
+}
+}
@@ -0,0 +1,76 @@
+#ifndef FASST_GEM_H
+#define FASST_GEM_H
+
+#include "typedefs.h"
+
+namespace fasst {
+class Sources;
+class MixCovMatrix;
+
+/*!
+ This class runs the generalized EM algorithm which estimates the parameters of
+ some sources from the mixture covariance matrices. The additive noise, which
+ is used to avoid local maxima, is computed from the mixture covariance
+ matrices and annealed from one iteration to the next one.
+ */
+class GEM {
+public:
+  /*!
+   The main constructor of the class computes the additive noise levels. Please
+   note that if the dimensions of the sources and of the mixture covariance
+   matrices are not consistent, the constructor will throw a `runtime_error`
+   exception.
+   \param sources the sources to be estimated
+   \param hatRx the mixture covariance matrices
+   \param iterations the number of iterations
+   */
+  GEM(Sources &sources, const MixCovMatrix &hatRx, int iterations);
+
+  /*!
+   This method runs the next iteration: it computes the natural statistics
+   (E-step) and then updates the mixing parameters and the spectral powers of
+   the sources (M-step).
+   \return the log-likelihood before the update
+   */
+  double next();
+
+  /*!
+   This method runs the next iteration on some consecutive time frames only,
+   with the additive noise of the whole mixture.
+   \param sources the sources on the time frames, see Sources::Sources(const
+   Sources &, int, int)
+   \param hatRx the mixture covariance matrices of the time frames
+   \return the log-likelihood of the time frames before the update
+   */
+  double next(Sources &sources, const MixCovMatrix &hatRx);
+
+  /*!
+   This method computes the additive noise of an iteration, which is annealed
+   from one iteration to the next one.
+   \param iteration the iteration index
+   \return the \f$F\f$-vector of \f$I \times I\f$-covariance matrices of
+   the noise
+   */
+  VectorMatrixXcd noise(int iteration) const;
+
+  /*!
+   \return the number of iterations already run
+   */
+  inline int iteration() const { return m_iteration; }
+
+  /*!
+   \return the total number of iterations
+   */
+  inline int iterations() const { return m_iterations; }
+
+private:
+  Sources &m_sources;
+  const MixCovMatrix &m_hatRx;
+  Eigen::VectorXd m_noiseBeg;
+  Eigen::VectorXd m_noiseEnd;
+  int m_iteration;
+  int m_iterations;
+};
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include "LocalSocket.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace fasst {
+
+// Fills the address of a socket path
+static sockaddr_un address(const char *path) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    stringstream s;
+    s << "Socket path " << path << " is too long.";
+    throw runtime_error(s.str());
+  }
+  strcpy(addr.sun_path, path);
+  return addr;
+}
+
+// Builds the message of a failed system call
+static runtime_error socketError(const char *what, const char *path) {
+  stringstream s;
+  s << "Can not " << what << " " << path << ". " << strerror(errno);
+  return runtime_error(s.str());
+}
+
+LocalSocket::LocalSocket(const char *path) {
+  sockaddr_un addr = address(path);
+  m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_fd < 0 ||
+      connect(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    runtime_error e = socketError("connect to", path);
+    if (m_fd >= 0) {
+      close(m_fd);
+    }
+    throw e;
+  }
+}
+
+LocalSocket::~LocalSocket() { close(m_fd); }
+
+int LocalSocket::listen(const char *path) {
+  sockaddr_un addr = address(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if (fd < 0 ||
+      bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      ::listen(fd, 16) < 0) {
+    runtime_error e = socketError("listen on", path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw e;
+  }
+  return fd;
+}
+
+int LocalSocket::accept(int listener) {
+  int fd;
+  do {
+    fd = ::accept(listener, 0, 0);
+  } while (fd < 0 && errno == EINTR);
+  if (fd < 0) {
+    throw socketError("accept on", "socket");
+  }
+  return fd;
+}
+
+void LocalSocket::read(void *data, size_t size) {
+  char *p = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t count = ::read(m_fd, p, size);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      throw runtime_error("Connection closed while reading.");
+    }
+    p += count;
+    size -= count;
+  }
+}
+
+void LocalSocket::write(const void *data, size_t size) {
+  const char *p = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t count = ::write(m_fd, p, size);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      throw runtime_error("Connection closed while writing.");
+    }
+    p += count;
+    size -= count;
+  }
+}
+}
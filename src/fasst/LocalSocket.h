@@ -0,0 +1,70 @@
+#ifndef FASST_LOCALSOCKET_H
+#define FASST_LOCALSOCKET_H
+
+#include <cstddef>
+
+namespace fasst {
+
+/*!
+ This class wraps a connected Unix domain socket, over which the separation
+ server and its clients exchange audio buffers. It is only available on Unix
+ systems.
+ */
+class LocalSocket {
+public:
+  /*!
+   This constructor connects to a server. Please note that if the connection
+   fails, the constructor will throw a `runtime_error` exception.
+   \param path the path of the socket
+   */
+  explicit LocalSocket(const char *path);
+
+  /*!
+   This constructor takes the ownership of a connected socket.
+   \param fd the file descriptor of the socket
+   */
+  explicit LocalSocket(int fd) : m_fd(fd) {}
+
+  ~LocalSocket();
+
+  /*!
+   This method creates a socket and listens on it. An existing socket file at
+   the same path is replaced. Please note that if the socket can't be created,
+   the method will throw a `runtime_error` exception.
+   \param path the path of the socket
+   \return the file descriptor of the listening socket
+   */
+  static int listen(const char *path);
+
+  /*!
+   This method waits for the next client of a listening socket.
+   \param listener the file descriptor of the listening socket
+   \return the file descriptor of the connected socket
+   */
+  static int accept(int listener);
+
+  /*!
+   This method reads exactly some bytes. Please note that if the connection is
+   closed before, the method will throw a `runtime_error` exception.
+   \param data the buffer to be filled
+   \param size the number of bytes
+   */
+  void read(void *data, size_t size);
+
+  /*!
+   This method writes exactly some bytes. Please note that if the connection is
+   closed before, the method will throw a `runtime_error` exception.
+   \param data the buffer to be written
+   \param size the number of bytes
+   */
+  void write(const void *data, size_t size);
+
+private:
+  LocalSocket(const LocalSocket &);
+  LocalSocket &operator=(const LocalSocket &);
+
+  int m_fd;
+};
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "MiniBatchGEM.h"
+#include "Sources.h"
+#include "MixCovMatrix.h"
+#include <algorithm>
+
+namespace fasst {
+MiniBatchGEM::MiniBatchGEM(Sources &sources, const MixCovMatrix &hatRx,
+                           int iterations, int blockFrames)
+    : m_sources(sources), m_hatRx(hatRx), m_gem(sources, hatRx, iterations),
+      m_blockFrames(std::min(blockFrames, hatRx.frames())), m_position(0),
+      m_random(1) {
+  int blocks = (hatRx.frames() + m_blockFrames - 1) / m_blockFrames;
+  for (int b = 0; b < blocks; b++) {
+    m_order.push_back(b * m_blockFrames);
+  }
+  shuffle();
+
+  // Fail now rather than at the first iteration if a source has no activations
+  Sources block(sources, 0, m_blockFrames);
+}
+
+double MiniBatchGEM::next() {
+  // Final full pass, the spectral powers of the frames which have not been
+  // visited by the last blocks are out of date
+  if (m_gem.iteration() == m_gem.iterations() - 1) {
+    m_sources.compV();
+    return m_gem.next();
+  }
+
+  if (m_position == m_order.size()) {
+    shuffle();
+    m_position = 0;
+  }
+  int first = m_order[m_position];
+  int frames = std::min(m_blockFrames, m_hatRx.frames() - first);
+  m_position++;
+
+  MixCovMatrix hatRx(m_hatRx, first, frames);
+  Sources block(m_sources, first, frames);
+  double log_like = m_gem.next(block, hatRx);
+  m_sources.replaceFrames(block, first);
+  return log_like;
+}
+
+void MiniBatchGEM::shuffle() {
+  // Fisher-Yates shuffle with a linear congruential generator, so that the
+  // order only depends on the number of blocks
+  for (int i = static_cast<int>(m_order.size()) - 1; i > 0; i--) {
+    m_random = m_random * 1103515245u + 12345u;
+    int j = static_cast<int>((m_random >> 16) % (i + 1));
+    std::swap(m_order[i], m_order[j]);
+  }
+}
+}
@@ -0,0 +1,70 @@
+#ifndef FASST_MINIBATCHGEM_H
+#define FASST_MINIBATCHGEM_H
+
+#include "GEM.h"
+#include <vector>
+
+namespace fasst {
+class Sources;
+class MixCovMatrix;
+
+/*!
+ This class runs the mini-batch variant of the generalized EM algorithm, which
+ is meant for very long mixtures. Each iteration only visits one block of
+ consecutive time frames: the E-step is computed on the block, the activations
+ of its frames are updated, and the mixing parameters and the other spectral
+ parameters are updated from the statistics of the block only. The blocks are
+ visited in a random order which is drawn again once every block has been
+ visited. The last iteration is a full pass over all the time frames.
+ */
+class MiniBatchGEM {
+public:
+  /*!
+   The main constructor of the class splits the time frames into blocks. Please
+   note that if the dimensions of the sources and of the mixture covariance
+   matrices are not consistent, or if a source has no activations, the
+   constructor will throw a `runtime_error` exception.
+   \param sources the sources to be estimated
+   \param hatRx the mixture covariance matrices
+   \param iterations the total number of iterations, including the final full
+   pass
+   \param blockFrames the number of time frames of each block
+   */
+  MiniBatchGEM(Sources &sources, const MixCovMatrix &hatRx, int iterations,
+               int blockFrames);
+
+  /*!
+   This method runs the next iteration, either on the next block or on all the
+   time frames for the last iteration.
+   \return the log-likelihood of the block, or of the whole mixture for the
+   last iteration, before the update
+   */
+  double next();
+
+  /*!
+   \return the number of iterations already run
+   */
+  inline int iteration() const { return m_gem.iteration(); }
+
+  /*!
+   \return the total number of iterations
+   */
+  inline int iterations() const { return m_gem.iterations(); }
+
+private:
+  /*!
+   This method draws a new random order of the blocks.
+   */
+  void shuffle();
+
+  Sources &m_sources;
+  const MixCovMatrix &m_hatRx;
+  GEM m_gem;
+  int m_blockFrames;
+  std::vector<int> m_order;
+  size_t m_position;
+  unsigned int m_random;
+};
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "MiniBatchGEM.h"
+#include "GEM.h"
+#include "MixCovMatrix.h"
+#include "Sources.h"
+#include "bench.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace fasst;
+
+TEST(MiniBatchGEM, SingleBlock) {
+  // With a block of all the time frames, each block iteration updates a copy
+  // of the sources whose mixing parameters, spectral parameters and
+  // activations all replace those of the sources, so that the run is the GEM
+  // algorithm, up to its final full pass
+  Audio x = benchAudio(4096, 2);
+  TFRepr X(x, 256);
+  MixCovMatrix hatRx(X);
+  string str = "<sources>";
+  for (int j = 0; j < 2; j++) {
+    str += benchSource(2, 3, X.bins(), X.frames(), true, j);
+  }
+  str += "</sources>";
+  QDomDocument batchDoc, miniBatchDoc;
+  ASSERT_TRUE(batchDoc.setContent(QString::fromStdString(str)));
+  ASSERT_TRUE(miniBatchDoc.setContent(QString::fromStdString(str)));
+  Sources batch(batchDoc.elementsByTagName("source"));
+  Sources miniBatch(miniBatchDoc.elementsByTagName("source"));
+
+  GEM gem(batch, hatRx, 3);
+  MiniBatchGEM miniBatchGEM(miniBatch, hatRx, 3, X.frames() + 1);
+  for (int iter = 0; iter < 3; iter++) {
+    double log_like = gem.next();
+    EXPECT_NEAR(log_like, miniBatchGEM.next(), 1e-9 * abs(log_like));
+  }
+  EXPECT_EQ(3, miniBatchGEM.iteration());
+
+  // GEM only updates the global mixing parameters
+  batch.syncMixingParameter();
+  miniBatch.syncMixingParameter();
+  batch.compV();
+  miniBatch.compV();
+  for (int j = 0; j < 2; j++) {
+    for (int f = 0; f < X.bins(); f++) {
+      EXPECT_LT((miniBatch[j].A(f) - batch[j].A(f)).norm(),
+                1e-9 * batch[j].A(f).norm());
+    }
+    EXPECT_LT((miniBatch[j].V() - batch[j].V()).abs().maxCoeff(),
+              1e-9 * batch[j].V().maxCoeff());
+  }
+
+  // W, U and G are only visible in the XML documents
+  batch.replace(batchDoc, batchDoc.elementsByTagName("source"));
+  miniBatch.replace(miniBatchDoc, miniBatchDoc.elementsByTagName("source"));
+  EXPECT_EQ(batchDoc.toString(), miniBatchDoc.toString());
+}
+
+TEST(MiniBatchGEM, Blocks) {
+  // With several blocks, a block iteration leaves the sources with the mixing
+  // and spectral parameters estimated on the block, and the final pass covers
+  // all the time frames
+  Audio x = benchAudio(4096, 2);
+  TFRepr X(x, 256);
+  MixCovMatrix hatRx(X);
+  int blockFrames = X.frames() / 3;
+  string str = "<sources>";
+  for (int j = 0; j < 2; j++) {
+    str += benchSource(2, 3, X.bins(), X.frames(), true, j);
+  }
+  str += "</sources>";
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(QString::fromStdString(str)));
+  Sources sources(doc.elementsByTagName("source"));
+  Sources initial = sources;
+  MiniBatchGEM miniBatchGEM(sources, hatRx, 2, blockFrames);
+  miniBatchGEM.next();
+  sources.syncMixingParameter();
+  sources.replace(doc, doc.elementsByTagName("source"));
+
+  // The block is drawn at random, rerun the block iteration from each block
+  // and keep the one which gives the same mixing parameters
+  const char *tags[] = {"A", "Wex", "Uex", "Gex"};
+  int matches = 0;
+  for (int first = 0; first < X.frames(); first += blockFrames) {
+    int frames = min(blockFrames, X.frames() - first);
+    Sources block(initial, first, frames);
+    GEM gem(initial, hatRx, 2);
+    gem.next(block, MixCovMatrix(hatRx, first, frames));
+    block.syncMixingParameter();
+    if (block[0].A(0) != sources[0].A(0)) {
+      continue;
+    }
+    matches++;
+
+    QDomDocument blockDoc;
+    ASSERT_TRUE(blockDoc.setContent(QString::fromStdString(str)));
+    block.replace(blockDoc, blockDoc.elementsByTagName("source"));
+    for (int j = 0; j < 2; j++) {
+      for (int t = 0; t < 4; t++) {
+        EXPECT_EQ(blockDoc.elementsByTagName(tags[t]).item(j).toElement().text(),
+                  doc.elementsByTagName(tags[t]).item(j).toElement().text());
+      }
+    }
+
+    // The final pass is the next GEM iteration on all the time frames
+    sources.compV();
+    Sources full = sources;
+    EXPECT_EQ(gem.next(full, hatRx), miniBatchGEM.next());
+    full.syncMixingParameter();
+    sources.syncMixingParameter();
+    for (int j = 0; j < 2; j++) {
+      for (int f = 0; f < X.bins(); f++) {
+        EXPECT_TRUE(full[j].A(f) == sources[j].A(f));
+      }
+    }
+  }
+  EXPECT_EQ(1, matches);
+  EXPECT_EQ(2, miniBatchGEM.iteration());
+}
@@ -1,7 +1,11 @@
 #include "MixCovMatrix.h"
 #include "TFRepr.h"
 #include "ERBRepr.h"
+#include "Audio.h"
+#include "Profiler.h"
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <stdexcept>
 
 using namespace std;
@@ -12,16 +16,7 @@ MixCovMatrix::MixCovMatrix(const Audio &x, std::string tfr_type, int wlen, int n
   if (tfr_type == "STFT") {
     // Compute time-frequency representation
     TFRepr X(x, wlen);
-    int F = X.bins();
-    int N = X.frames();
-
-    // Compute covariance matrix
-    _set(ArrayMatrixXcd(F, N));
-    for (int f = 0; f < F; f++) {
-      for (int n = 0; n < N; n++) {
-	(*this)(f, n) = X(f, n) * X(f, n).adjoint();
-      }
-    }
+    compute(X);
   } else if (tfr_type == "ERB") {
     _set(ERBRepr(x, wlen, nbin));
   } else {
@@ -31,43 +26,89 @@ MixCovMatrix::MixCovMatrix(const Audio &x, std::string tfr_type, int wlen, int n
   }
 }
 
-MixCovMatrix::MixCovMatrix(const char *fname) {
-  // Open fname
-  ifstream in(fname, ios_base::binary);
-  if (!in.good()) {
+MixCovMatrix::MixCovMatrix(AudioReader &reader, std::string tfr_type, int wlen, int nbin) {
+  if (tfr_type == "STFT" && reader.samples() >= 0) {
+    // Compute time-frequency representation while reading
+    TFRepr X(reader, wlen);
+    compute(X);
+  } else if (tfr_type == "STFT") {
+    // The number of frames of a stream of unknown length is only known once
+    // it has been read
+    Audio x(reader);
+    TFRepr X(x, wlen);
+    compute(X);
+  } else if (tfr_type == "ERB") {
+    Audio x(reader);
+    _set(ERBRepr(x, wlen, nbin));
+  } else {
     stringstream s;
-    s << "Can not open " << fname << ". ";
-    s << "File probably doesn't exist or isn't readable.";
+    s << "Wrong TFR type" << tfr_type << ".";
     throw runtime_error(s.str());
   }
+}
 
-  // Read ndim
-  int ndim = 0;
-  in.read(reinterpret_cast<char *>(&ndim), sizeof(int));
+MixCovMatrix::MixCovMatrix(const TFRepr &X) { compute(X); }
 
-  // Read dim
-  vector<int> dim(ndim);
-  in.read(reinterpret_cast<char *>(&dim[0]), sizeof(int) * ndim);
+void MixCovMatrix::allocate(int bins, int frames, int channels) {
+  _set(ArrayMatrixXcd(bins, frames));
+#pragma omp parallel for schedule(static)
+  for (int n = 0; n < frames; n++) {
+    for (int f = 0; f < bins; f++) {
+      (*this)(f, n).resize(channels, channels);
+    }
+  }
+}
 
-  int ndata = 1;
-  for (int i = 0; i < ndim; i++) {
-    ndata *= dim[i];
+void MixCovMatrix::compute(const TFRepr &X) {
+  int F = X.bins();
+  int N = X.frames();
+
+  // Compute covariance matrix
+  allocate(F, N, X.channels());
+#pragma omp parallel for schedule(static)
+  for (int n = 0; n < N; n++) {
+    for (int f = 0; f < F; f++) {
+      (*this)(f, n) = X(f, n) * X(f, n).adjoint();
+    }
   }
+}
 
-  // Read data to a buffer
-  vector<float> data(ndata);
-  in.read(reinterpret_cast<char *>(&data[0]), sizeof(float) * ndata);
-  in.close();
+MixCovMatrix::MixCovMatrix(const char *fname) {
+  ScopedTimer timer("rx_load");
+  MixCovMatrixReader reader(fname);
+  read(reader, reader.frames());
+}
 
-  int I = static_cast<int>(std::sqrt(static_cast<double>(dim[0])));
-  int F = dim[1];
-  int N = dim[2];
+MixCovMatrix::MixCovMatrix(MixCovMatrixReader &reader, int frames) {
+  read(reader, frames);
+}
+
+MixCovMatrix::MixCovMatrix(const char *fname, int first, int bins) {
+  ScopedTimer timer("rx_load");
+  MixCovMatrixReader reader(fname);
+  allocate(bins, reader.frames(), reader.channels());
+  while (reader.remaining() > 0) {
+    int n = reader.frames() - reader.remaining();
+    MixCovMatrix block(reader, 256);
+    middleCols(n, block.frames()) = block.middleRows(first, bins);
+  }
+}
+
+void MixCovMatrix::read(MixCovMatrixReader &reader, int frames) {
+  int I = reader.channels();
+  int F = reader.bins();
+  int N = std::min(frames, reader.remaining());
+
+  // Read data to a buffer
+  vector<float> data;
+  reader.read(data, N);
 
   // Load buffer
-  _set(ArrayMatrixXcd(F, N));
+  allocate(F, N, I);
+#pragma omp parallel for schedule(static)
   for (int n = 0; n < N; n++) {
     for (int f = 0; f < F; f++) {
-      MatrixXcd Rx_fn(I, I);
+      MatrixXcd &Rx_fn = (*this)(f, n);
 
       // Real diagonal elements
       int ind1 = f * I * I + n * F * I * I;
@@ -85,7 +126,6 @@ MixCovMatrix::MixCovMatrix(const char *fname) {
         }
         sum += I - 1 - i1;
       }
-      (*this)(f, n) = Rx_fn;
     }
   }
 }
@@ -95,14 +135,18 @@ void MixCovMatrix::write(const char *fname) {
   int N = frames();
   int I = channels();
 
-  // Open fname
-  ofstream out(fname, ios_base::binary);
-  if (!out.good()) {
-    stringstream s;
-    s << "Can not open " << fname << ". ";
-    s << "You probably don't have write access to this location.";
-    throw runtime_error(s.str());
+  // Open fname, - being the standard output
+  ofstream file;
+  if (string(fname) != "-") {
+    file.open(fname, ios_base::binary);
+    if (!file.good()) {
+      stringstream s;
+      s << "Can not open " << fname << ". ";
+      s << "You probably don't have write access to this location.";
+      throw runtime_error(s.str());
+    }
   }
+  ostream &out = file.is_open() ? file : cout;
 
   // Write ndim
   int ndim = 3;
@@ -142,4 +186,49 @@ void MixCovMatrix::write(const char *fname) {
   // Write buffer to file
   out.write(reinterpret_cast<char *>(&data[0]), sizeof(float) * ndata);
 }
+
+MixCovMatrixReader::MixCovMatrixReader(const char *fname) : m_position(0) {
+  // Open fname, - being the standard input
+  if (string(fname) != "-") {
+    m_file.open(fname, ios_base::binary);
+    if (!m_file.good()) {
+      stringstream s;
+      s << "Can not open " << fname << ". ";
+      s << "File probably doesn't exist or isn't readable.";
+      throw runtime_error(s.str());
+    }
+  }
+  m_in = m_file.is_open() ? static_cast<istream *>(&m_file) : &cin;
+
+  // Read ndim
+  int ndim = 0;
+  m_in->read(reinterpret_cast<char *>(&ndim), sizeof(int));
+  if (!m_in->good() || ndim != 3) {
+    stringstream s;
+    s << fname << " is not a mixture covariance matrices file.";
+    throw runtime_error(s.str());
+  }
+
+  // Read dim
+  vector<int> dim(ndim);
+  m_in->read(reinterpret_cast<char *>(&dim[0]), sizeof(int) * ndim);
+
+  m_channels = static_cast<int>(std::sqrt(static_cast<double>(dim[0])));
+  m_bins = dim[1];
+  m_frames = dim[2];
+}
+
+void MixCovMatrixReader::read(vector<float> &data, int frames) {
+  int I = m_channels;
+  data.resize(I * I * m_bins * frames);
+  if (frames == 0) {
+    return;
+  }
+  m_in->read(reinterpret_cast<char *>(&data[0]), sizeof(float) * data.size());
+  if (!m_in->good()) {
+    throw runtime_error("Error:\tthe mixture covariance matrices file is "
+                        "truncated.");
+  }
+  m_position += frames;
+}
 }
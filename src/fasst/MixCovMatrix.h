@@ -2,9 +2,14 @@
 #define FASST_MIXCOVMATRIX_H
 
 #include "typedefs.h"
+#include <fstream>
+#include <vector>
 
 namespace fasst {
 class Audio;
+class AudioReader;
+class TFRepr;
+class MixCovMatrixReader;
 
 /*!
  This class contains a mixture covariance matrix. The data is stored in an
@@ -37,6 +42,25 @@ public:
    */
   MixCovMatrix(const Audio &x, std::string tfr_type, int wlen, int nbin);
 
+  /*!
+   This constructor computes the mixture covariance matrices of an audio signal
+   while it is being read. With the STFT transform, the audio signal never has
+   to be held in memory.
+   \param reader an audio reader
+   \param tfr_type is either STFT or ERB
+   \param wlen the window length _ie._ the length (in audio samples) of one time
+   frame
+   \param nbin the number of frequency bins
+   */
+  MixCovMatrix(AudioReader &reader, std::string tfr_type, int wlen, int nbin);
+
+  /*!
+   This constructor computes the mixture covariance matrices from an already
+   computed STFT, which can then be reused to filter the sources.
+   \param X the STFT of a multichannel audio signal
+   */
+  MixCovMatrix(const TFRepr &X);
+
   /*!
    This constructor reads a binary file and loads the mixture covariance
    matrices from it. Please note that if the file doesn't exist or is not
@@ -45,11 +69,42 @@ public:
    */
   MixCovMatrix(const char *fname);
 
+  /*!
+   This constructor reads the next time frames of a binary file, so that the
+   mixture covariance matrices can be processed block by block. If less frames
+   remain, they are all read.
+   \param reader a binary file reader
+   \param frames the number of time frames to be read
+   */
+  MixCovMatrix(MixCovMatrixReader &reader, int frames);
+
+  /*!
+   This constructor reads some consecutive frequency bins of a binary file. The
+   file is read block of frames by block of frames, so that the other bins
+   never have to be held in memory. Please note that if the file doesn't exist
+   or is not readable, the constructor will throw a `runtime_error` exception.
+   \param fname the name of the input binary file
+   \param first the index of the first frequency bin
+   \param bins the number of frequency bins
+   */
+  MixCovMatrix(const char *fname, int first, int bins);
+
+  /*!
+   This constructor copies some consecutive time frames of other mixture
+   covariance matrices.
+   \param hatRx the mixture covariance matrices to be copied
+   \param first the index of the first time frame
+   \param frames the number of time frames
+   */
+  MixCovMatrix(const MixCovMatrix &hatRx, int first, int frames)
+      : ArrayMatrixXcd(hatRx.middleCols(first, frames)) {}
+
   /*!
    This method writes the mixture covariance matrices to a binary file. Please
    note that if the file is not writable, this method will throw a
    `runtime_error` exception.
-   \param fname the name of the output binary file
+   \param fname the name of the output binary file, or `-` for the standard
+   output
    */
   void write(const char *fname);
 
@@ -67,6 +122,85 @@ public:
    \return the number of audio channels
    */
   inline int channels() const { return (*this)(0, 0).rows(); }
+
+private:
+  /*!
+   This method allocates the mixture covariance matrices. Each time frame is
+   allocated by the thread which later works on it in NaturalStatistics, so
+   that its memory is local to that thread.
+   \param bins the number of frequency bins
+   \param frames the number of time frames
+   \param channels the number of audio channels
+   */
+  void allocate(int bins, int frames, int channels);
+
+  /*!
+   This method computes the mixture covariance matrices from a time-frequency
+   representation.
+   \param X the time-frequency representation of the mixture
+   */
+  void compute(const TFRepr &X);
+
+  /*!
+   This method reads the next time frames of a binary file.
+   \param reader a binary file reader
+   \param frames the number of time frames to be read
+   */
+  void read(MixCovMatrixReader &reader, int frames);
+};
+
+/*!
+ This class reads a binary file of mixture covariance matrices frame by frame,
+ so that the whole file never has to be held in memory.
+ */
+class MixCovMatrixReader {
+public:
+  /*!
+   The main constructor of the class opens a binary file and reads its header.
+   Please note that if the file doesn't exist or is not readable, the
+   constructor will throw a `runtime_error` exception.
+   \param fname the name of the input binary file, or `-` for the standard
+   input
+   */
+  MixCovMatrixReader(const char *fname);
+
+  /*!
+   This method reads the packed data of the next time frames, see the \ref
+   binfileformat page. Please note that if the file is truncated, the method
+   will throw a `runtime_error` exception.
+   \param data the buffer to be filled
+   \param frames the number of time frames to be read
+   */
+  void read(std::vector<float> &data, int frames);
+
+  /*!
+   \return the number of frequency bins
+   */
+  inline int bins() const { return m_bins; }
+
+  /*!
+   \return the number of time frames of the file
+   */
+  inline int frames() const { return m_frames; }
+
+  /*!
+   \return the number of audio channels
+   */
+  inline int channels() const { return m_channels; }
+
+  /*!
+   \return the number of time frames which have not been read yet
+   */
+  inline int remaining() const { return m_frames - m_position; }
+
+private:
+  MixCovMatrixReader(const MixCovMatrixReader &);
+  MixCovMatrixReader &operator=(const MixCovMatrixReader &);
+
+  std::ifstream m_file;
+  std::istream *m_in;
+  int m_bins, m_frames, m_channels;
+  int m_position;
 };
 }
 
@@ -0,0 +1,46 @@
+#include "MixCovMatrix.h"
+#include "bench.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+
+using namespace fasst;
+
+static const char *FNAME = "MixCovMatrix_bench.bin";
+
+// Sweeps the number of channels, of bins and of frames
+static void channelsBinsAndFrames(benchmark::internal::Benchmark *b) {
+  for (int I = 2; I <= 8; I *= 2) {
+    for (int F = 257; F <= 1025; F = F * 2 - 1) {
+      for (int N = 250; N <= 1000; N *= 2) {
+        b->Args({I, F, N});
+      }
+    }
+  }
+}
+
+static void MixCovMatrix_write(benchmark::State &state) {
+  int I = state.range(0);
+  int F = state.range(1);
+  int N = state.range(2);
+  MixCovMatrix hatRx(benchTFRepr(I, F, N));
+  while (state.KeepRunning()) {
+    hatRx.write(FNAME);
+  }
+  std::remove(FNAME);
+  state.SetItemsProcessed(state.iterations() * F * N);
+}
+BENCHMARK(MixCovMatrix_write)->Apply(channelsBinsAndFrames);
+
+static void MixCovMatrix_read(benchmark::State &state) {
+  int I = state.range(0);
+  int F = state.range(1);
+  int N = state.range(2);
+  MixCovMatrix(benchTFRepr(I, F, N)).write(FNAME);
+  while (state.KeepRunning()) {
+    MixCovMatrix hatRx(FNAME);
+    benchmark::DoNotOptimize(hatRx.data());
+  }
+  std::remove(FNAME);
+  state.SetItemsProcessed(state.iterations() * F * N);
+}
+BENCHMARK(MixCovMatrix_read)->Apply(channelsBinsAndFrames);
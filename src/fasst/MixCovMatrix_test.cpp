@@ -119,3 +119,33 @@ TEST(MixCovMatrix, readwrite) {
     }
   }
 }
+
+TEST(MixCovMatrix, readBlocks) {
+  // input: 32 samples, 2 channels, x=rand, wlen=4
+  // assert: reading the binary file by blocks of 3 frames gives the same
+  // matrices as reading it at once, and the last block is shorter
+  ArrayXXd array = ArrayXXd::Random(32, 2);
+  fasst::Audio x(array);
+  int wlen = 4;
+
+  fasst::MixCovMatrix Rx(x, "STFT", wlen, 0);
+  Rx.write("tmp_blocks.bin");
+  fasst::MixCovMatrix Rx1("tmp_blocks.bin");
+
+  fasst::MixCovMatrixReader reader("tmp_blocks.bin");
+  ASSERT_EQ(reader.frames(), Rx1.frames());
+  ASSERT_EQ(reader.bins(), Rx1.bins());
+  ASSERT_EQ(reader.channels(), Rx1.channels());
+  int first = 0;
+  while (reader.remaining() > 0) {
+    fasst::MixCovMatrix Rx2(reader, 3);
+    ASSERT_EQ(Rx2.frames(), std::min(3, Rx1.frames() - first));
+    for (int n = 0; n < Rx2.frames(); n++) {
+      for (int f = 0; f < Rx2.bins(); f++) {
+        ASSERT_TRUE(Rx2(f, n) == Rx1(f, first + n));
+      }
+    }
+    first += Rx2.frames();
+  }
+  ASSERT_EQ(first, Rx1.frames());
+}
@@ -2,10 +2,142 @@
 #include "MixCovMatrix.h"
 #include "Sources.h"
 #include <Eigen/Dense>
+#include <vector>
 
 using namespace Eigen;
+using namespace std;
+
+// The stereo E-step is compiled for several instruction sets, the best one
+// being chosen at run time
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 &&              \
+    defined(__x86_64__) && defined(__linux__)
+#define FASST_TARGET_CLONES                                                    \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define FASST_TARGET_CLONES
+#endif
 
 namespace fasst {
+// Number of frequency bins processed at once by the stereo E-step
+static const int BLOCK = 8;
+
+// E-step of a block of bins of a stereo mixture (Eq. 21 to 25) and their
+// log-likelihood (Eq. 16). The 2 x 2 matrices are inverted in closed form,
+// and every array holds a plane of BLOCK values for each matrix entry, real
+// and imaginary parts apart, so that the loops over the bins are vectorized:
+// - phi: Phi, R planes
+// - a: A, planes (i, re/im, r)
+// - sb, rx: Sigma_b and hatRx, planes (0, 0), (1, 1), re (1, 0), im (1, 0)
+// - omega: buffer of Omega_s, planes (r, i, re/im)
+// - rxs: hatRxs, planes (i, re/im, r)
+// - rs: hatRs, planes (r, q, re/im)
+// - ll: the log-likelihood of each bin
+FASST_TARGET_CLONES
+static void stereoEStep(int R, const double *phi, const double *a,
+                        const double *sb, const double *rx, double *omega,
+                        double *rxs, double *rs, double *ll) {
+  const int B = BLOCK;
+  const double *x00 = rx, *x11 = rx + B, *x10r = rx + 2 * B,
+               *x10i = rx + 3 * B;
+
+  // Eq. 24
+  double s00[B], s11[B], s10r[B], s10i[B];
+  for (int k = 0; k < B; k++) {
+    s00[k] = sb[k];
+    s11[k] = sb[B + k];
+    s10r[k] = sb[2 * B + k];
+    s10i[k] = sb[3 * B + k];
+  }
+  for (int r = 0; r < R; r++) {
+    const double *p = phi + r * B;
+    const double *a0r = a + r * B, *a0i = a + (R + r) * B,
+                 *a1r = a + (2 * R + r) * B, *a1i = a + (3 * R + r) * B;
+    for (int k = 0; k < B; k++) {
+      s00[k] += p[k] * (a0r[k] * a0r[k] + a0i[k] * a0i[k]);
+      s11[k] += p[k] * (a1r[k] * a1r[k] + a1i[k] * a1i[k]);
+      s10r[k] += p[k] * (a1r[k] * a0r[k] + a1i[k] * a0i[k]);
+      s10i[k] += p[k] * (a1i[k] * a0r[k] - a1r[k] * a0i[k]);
+    }
+  }
+
+  // Sigma_x^-1, and the log-likelihood: Eq. 16
+  double i00[B], i11[B], i10r[B], i10i[B], det[B];
+  for (int k = 0; k < B; k++) {
+    det[k] = s00[k] * s11[k] - s10r[k] * s10r[k] - s10i[k] * s10i[k];
+    double inv = 1 / det[k];
+    i00[k] = s11[k] * inv;
+    i11[k] = s00[k] * inv;
+    i10r[k] = -s10r[k] * inv;
+    i10i[k] = -s10i[k] * inv;
+  }
+  for (int k = 0; k < B; k++) {
+    ll[k] = -(i00[k] * x00[k] + i11[k] * x11[k] +
+              2 * (i10r[k] * x10r[k] + i10i[k] * x10i[k]) +
+              log(det[k] * M_PI));
+  }
+
+  // Eq. 23
+  for (int r = 0; r < R; r++) {
+    const double *p = phi + r * B;
+    const double *a0r = a + r * B, *a0i = a + (R + r) * B,
+                 *a1r = a + (2 * R + r) * B, *a1i = a + (3 * R + r) * B;
+    double *o0r = omega + 4 * r * B, *o0i = o0r + B, *o1r = o0r + 2 * B,
+           *o1i = o0r + 3 * B;
+    for (int k = 0; k < B; k++) {
+      o0r[k] = p[k] * (a0r[k] * i00[k] + a1r[k] * i10r[k] + a1i[k] * i10i[k]);
+      o0i[k] = p[k] * (-a0i[k] * i00[k] + a1r[k] * i10i[k] - a1i[k] * i10r[k]);
+      o1r[k] = p[k] * (a0r[k] * i10r[k] - a0i[k] * i10i[k] + a1r[k] * i11[k]);
+      o1i[k] = p[k] * (-a0r[k] * i10i[k] - a0i[k] * i10r[k] - a1i[k] * i11[k]);
+    }
+  }
+
+  // Eq. 21
+  for (int r = 0; r < R; r++) {
+    const double *o0r = omega + 4 * r * B, *o0i = o0r + B, *o1r = o0r + 2 * B,
+                 *o1i = o0r + 3 * B;
+    double *p0r = rxs + r * B, *p0i = rxs + (R + r) * B,
+           *p1r = rxs + (2 * R + r) * B, *p1i = rxs + (3 * R + r) * B;
+    for (int k = 0; k < B; k++) {
+      p0r[k] = x00[k] * o0r[k] + x10r[k] * o1r[k] - x10i[k] * o1i[k];
+      p0i[k] = -x00[k] * o0i[k] - x10r[k] * o1i[k] - x10i[k] * o1r[k];
+      p1r[k] = x10r[k] * o0r[k] + x10i[k] * o0i[k] + x11[k] * o1r[k];
+      p1i[k] = x10i[k] * o0r[k] - x10r[k] * o0i[k] - x11[k] * o1i[k];
+    }
+  }
+
+  // Eq. 22, hatRs = Omega_s * (hatRxs - A * Sigma_s) + Sigma_s
+  for (int q = 0; q < R; q++) {
+    const double *p = phi + q * B;
+    const double *a0r = a + q * B, *a0i = a + (R + q) * B,
+                 *a1r = a + (2 * R + q) * B, *a1i = a + (3 * R + q) * B;
+    const double *p0r = rxs + q * B, *p0i = rxs + (R + q) * B,
+                 *p1r = rxs + (2 * R + q) * B, *p1i = rxs + (3 * R + q) * B;
+    double d0r[B], d0i[B], d1r[B], d1i[B];
+    for (int k = 0; k < B; k++) {
+      d0r[k] = p0r[k] - a0r[k] * p[k];
+      d0i[k] = p0i[k] - a0i[k] * p[k];
+      d1r[k] = p1r[k] - a1r[k] * p[k];
+      d1i[k] = p1i[k] - a1i[k] * p[k];
+    }
+    for (int r = 0; r < R; r++) {
+      const double *o0r = omega + 4 * r * B, *o0i = o0r + B,
+                   *o1r = o0r + 2 * B, *o1i = o0r + 3 * B;
+      double *re = rs + 2 * (r * R + q) * B, *im = re + B;
+      for (int k = 0; k < B; k++) {
+        re[k] = o0r[k] * d0r[k] - o0i[k] * d0i[k] + o1r[k] * d1r[k] -
+                o1i[k] * d1i[k];
+        im[k] = o0r[k] * d0i[k] + o0i[k] * d0r[k] + o1r[k] * d1i[k] +
+                o1i[k] * d1r[k];
+      }
+      if (r == q) {
+        for (int k = 0; k < B; k++) {
+          re[k] += p[k];
+        }
+      }
+    }
+  }
+}
+
 NaturalStatistics::NaturalStatistics(const Sources &sources,
                                      const MixCovMatrix &hatRx,
                                      const VectorMatrixXcd &Sigma_b) {
@@ -15,11 +147,44 @@ NaturalStatistics::NaturalStatistics(const Sources &sources,
   m_hatRxs = ArrayMatrixXcd(F, N);
   m_hatRs = ArrayMatrixXcd(F, N);
 
+  int I = hatRx.channels();
+  if (I == 2) {
+    m_logLikelihood = stereo(sources, hatRx, Sigma_b);
+    return;
+  }
+
   int R = sources.A(0).cols();
 
+  // With instantaneous mixing only, A is the same for all the bins, and
+  // Sigma_x is a weighted sum of the fixed outer products A_r * A_r^H
+  bool inst = sources.isInst();
+  VectorMatrixXcd outer(inst ? R : 0);
+  for (int r = 0; r < outer.size(); r++) {
+    outer(r) = sources.A(0).col(r) * sources.A(0).col(r).adjoint();
+  }
+
+  // When there are fewer sources than channels and the noise is a scaled
+  // identity, Sigma_x is a low-rank update of it and the E-step works in the
+  // R x R space (Woodbury identity and matrix determinant lemma). sigma2(f) is
+  // the noise variance of the bins which take this path, and A^H * A doesn't
+  // depend on the frame, nor on the bin with instantaneous mixing.
+  VectorXd sigma2 = VectorXd::Zero(F);
+  VectorMatrixXcd AhA(inst ? 1 : F);
+  for (int f = 0; f < F; f++) {
+    double s = Sigma_b(f)(0, 0).real();
+    if (R < I && s > 0 && Sigma_b(f) == MatrixXcd::Identity(I, I) * s) {
+      sigma2(f) = s;
+      if (AhA(inst ? 0 : f).size() == 0) {
+        AhA(inst ? 0 : f) = sources.A(f).adjoint() * sources.A(f);
+      }
+    }
+  }
+
   double log_like = 0;
 
-#pragma omp parallel for reduction(+ : log_like)
+  // The frames are split between the threads as in MixCovMatrix, so that each
+  // thread reads the hatRx it has allocated and allocates its own statistics
+#pragma omp parallel for schedule(static) reduction(+ : log_like)
   for (int n = 0; n < N; n++) {
     for (int f = 0; f < F; f++) {
       // Eq. 25 
@@ -36,13 +201,47 @@ NaturalStatistics::NaturalStatistics(const Sources &sources,
       DiagonalMatrixXd Sigma_s(R);
       Sigma_s.diagonal() = Phi;
 
-      // Eq. 24
-      MatrixXcd Sigma_x =
-          sources.A(f) * Sigma_s * sources.A(f).adjoint() + Sigma_b(f);
-      MatrixXcd Sigma_x_inverse = Sigma_x.inverse();
+      MatrixXcd Omega_s;
+      double trace, log_det;
+      if (sigma2(f) > 0) {
+        // With C = Sigma_s^1/2 and K = sigma2 * I + C * A^H * A * C,
+        // Sigma_x^-1 = (I - A * C * K^-1 * C * A^H) / sigma2 and
+        // det(Sigma_x) = sigma2^(I - R) * det(K)
+        DiagonalMatrixXd C(R);
+        C.diagonal() = Phi.cwiseSqrt();
+        MatrixXcd K = C * AhA(inst ? 0 : f) * C;
+        K.diagonal().array() += sigma2(f);
+        LLT<MatrixXcd> llt(K);
+
+        // Eq. 23, which simplifies to Omega_s = C * K^-1 * C * A^H
+        Omega_s = C * llt.solve(C * sources.A(f).adjoint());
+
+        trace = (hatRx(f, n).trace() -
+                 (Omega_s * hatRx(f, n) * sources.A(f)).trace()).real() /
+                sigma2(f);
+        log_det = (I - R) * log(sigma2(f)) +
+                  2 * llt.matrixLLT().diagonal().real().array().log().sum();
+      } else {
+        // Eq. 24, Sigma_x being Hermitian positive definite, it is
+        // factorized once as L * L^H rather than inverted
+        MatrixXcd Sigma_x = Sigma_b(f);
+        if (inst) {
+          for (int r = 0; r < R; r++) {
+            Sigma_x += Phi(r) * outer(r);
+          }
+        } else {
+          Sigma_x += sources.A(f) * Sigma_s * sources.A(f).adjoint();
+        }
+        LLT<MatrixXcd> llt(Sigma_x);
+
+        // Eq. 23, Omega_s^H = Sigma_x^-1 * A * Sigma_s being a solve
+        Omega_s = llt.solve(sources.A(f) * Sigma_s).adjoint();
 
-      // Eq. 23
-      MatrixXcd Omega_s = Sigma_s * sources.A(f).adjoint() * Sigma_x_inverse;
+        // The log-determinant of Sigma_x is taken from the diagonal of L,
+        // which doesn't overflow with many channels
+        trace = llt.solve(hatRx(f, n)).trace().real();
+        log_det = 2 * llt.matrixLLT().diagonal().real().array().log().sum();
+      }
 
       // Eq. 22
       m_hatRs(f, n) =
@@ -53,11 +252,113 @@ NaturalStatistics::NaturalStatistics(const Sources &sources,
       m_hatRxs(f, n) = hatRx(f, n) * Omega_s.adjoint();
 
       // Log-likelihood: Eq. 16
-      log_like -= (Sigma_x_inverse * hatRx(f, n)).real().trace() +
-                  log(Sigma_x.determinant().real() * M_PI);
+      log_like -= trace + log_det + log(M_PI);
     }
   }
   log_like /= (F * N);
   m_logLikelihood = log_like;
 }
+
+double NaturalStatistics::stereo(const Sources &sources,
+                                 const MixCovMatrix &hatRx,
+                                 const VectorMatrixXcd &Sigma_b) {
+  const int B = BLOCK;
+  int F = hatRx.bins();
+  int N = hatRx.frames();
+  int R = sources.A(0).cols();
+  int blocks = (F + B - 1) / B;
+
+  // Source of each rank
+  vector<int> source(R);
+  int j = 0;
+  int sum = 0;
+  for (int r = 0; r < R; r++) {
+    if (r == sources[j].rank() + sum) {
+      sum += sources[j].rank();
+      j++;
+    }
+    source[r] = j;
+  }
+
+  // A and Sigma_b don't depend on the frame, their planes are filled once.
+  // The bins which pad the last block have Sigma_x = I.
+  vector<double> a(blocks * 4 * R * B, 0.);
+  vector<double> sb(blocks * 4 * B, 0.);
+  for (int f = 0; f < blocks * B; f++) {
+    double *ab = &a[(f / B) * 4 * R * B + f % B];
+    double *sbb = &sb[(f / B) * 4 * B + f % B];
+    if (f >= F) {
+      sbb[0] = 1;
+      sbb[B] = 1;
+      continue;
+    }
+    for (int r = 0; r < R; r++) {
+      ab[r * B] = sources.A(f)(0, r).real();
+      ab[(R + r) * B] = sources.A(f)(0, r).imag();
+      ab[(2 * R + r) * B] = sources.A(f)(1, r).real();
+      ab[(3 * R + r) * B] = sources.A(f)(1, r).imag();
+    }
+    sbb[0] = Sigma_b(f)(0, 0).real();
+    sbb[B] = Sigma_b(f)(1, 1).real();
+    sbb[2 * B] = Sigma_b(f)(1, 0).real();
+    sbb[3 * B] = Sigma_b(f)(1, 0).imag();
+  }
+
+  double log_like = 0;
+
+  // The frames are split between the threads as in the general case
+#pragma omp parallel reduction(+ : log_like)
+  {
+    vector<double> phi(R * B), rx(4 * B), omega(4 * R * B), rxs(4 * R * B),
+        rs(2 * R * R * B);
+    double ll[BLOCK];
+#pragma omp for schedule(static)
+    for (int n = 0; n < N; n++) {
+      for (int b = 0; b < blocks; b++) {
+        // Eq. 25, and hatRx
+        for (int k = 0; k < B; k++) {
+          int f = b * B + k;
+          for (int r = 0; r < R; r++) {
+            phi[r * B + k] = f < F ? sources[source[r]].V(f, n) : 0;
+          }
+          if (f < F) {
+            const MatrixXcd &X = hatRx(f, n);
+            rx[k] = X(0, 0).real();
+            rx[B + k] = X(1, 1).real();
+            rx[2 * B + k] = X(1, 0).real();
+            rx[3 * B + k] = X(1, 0).imag();
+          } else {
+            rx[k] = rx[B + k] = rx[2 * B + k] = rx[3 * B + k] = 0;
+          }
+        }
+
+        stereoEStep(R, &phi[0], &a[b * 4 * R * B], &sb[b * 4 * B], &rx[0],
+                    &omega[0], &rxs[0], &rs[0], ll);
+
+        for (int k = 0; k < B && b * B + k < F; k++) {
+          int f = b * B + k;
+          log_like += ll[k];
+          MatrixXcd &hatRxs = m_hatRxs(f, n);
+          hatRxs.resize(2, R);
+          for (int i = 0; i < 2; i++) {
+            for (int r = 0; r < R; r++) {
+              hatRxs(i, r) =
+                  complex<double>(rxs[(2 * i * R + r) * B + k],
+                                  rxs[((2 * i + 1) * R + r) * B + k]);
+            }
+          }
+          MatrixXcd &hatRs = m_hatRs(f, n);
+          hatRs.resize(R, R);
+          for (int r = 0; r < R; r++) {
+            for (int q = 0; q < R; q++) {
+              hatRs(r, q) = complex<double>(rs[2 * (r * R + q) * B + k],
+                                            rs[(2 * (r * R + q) + 1) * B + k]);
+            }
+          }
+        }
+      }
+    }
+  }
+  return log_like / (F * N);
+}
 }
@@ -55,6 +55,18 @@ public:
   }
 
 private:
+  /*!
+   This method computes the E-step and the log-likelihood of a stereo mixture,
+   whose 2 \f$\times\f$ 2 matrices are inverted in closed form, several
+   frequency bins at once.
+   \param sources
+   \param hatRx
+   \param Sigma_b
+   \return the value of the log-likelihood.
+   */
+  double stereo(const Sources &sources, const MixCovMatrix &hatRx,
+                const VectorMatrixXcd &Sigma_b);
+
   ArrayMatrixXcd m_hatRxs;
   ArrayMatrixXcd m_hatRs;
   double m_logLikelihood;
@@ -0,0 +1,38 @@
+#include "NaturalStatistics.h"
+#include "bench.h"
+#include <benchmark/benchmark.h>
+
+using namespace fasst;
+
+// Sweeps the number of channels, the number of sources of rank 1, the number
+// of bins and the number of frames
+static void channelsRanksBinsAndFrames(benchmark::internal::Benchmark *b) {
+  for (int I = 2; I <= 8; I *= 2) {
+    for (int R = 2; R <= 8; R *= 2) {
+      for (int F = 257; F <= 1025; F = F * 2 - 1) {
+        for (int N = 250; N <= 1000; N *= 4) {
+          b->Args({I, R, F, N});
+        }
+      }
+    }
+  }
+}
+
+static void NaturalStatistics_estep(benchmark::State &state) {
+  int I = state.range(0);
+  int R = state.range(1);
+  int F = state.range(2);
+  int N = state.range(3);
+  Sources sources = benchSources(I, R, 8, F, N, false);
+  MixCovMatrix hatRx(benchTFRepr(I, F, N));
+  VectorMatrixXcd Sigma_b(F);
+  for (int f = 0; f < F; f++) {
+    Sigma_b(f) = Eigen::MatrixXcd::Identity(I, I) * 1e-2;
+  }
+  while (state.KeepRunning()) {
+    NaturalStatistics stats(sources, hatRx, Sigma_b);
+    benchmark::DoNotOptimize(stats.logLikelihood());
+  }
+  state.SetItemsProcessed(state.iterations() * F * N);
+}
+BENCHMARK(NaturalStatistics_estep)->Apply(channelsRanksBinsAndFrames);
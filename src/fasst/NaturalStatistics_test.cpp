@@ -0,0 +1,228 @@
+#include "NaturalStatistics.h"
+#include "MixCovMatrix.h"
+#include "Sources.h"
+#include "bench.h"
+#include <Eigen/Dense>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace Eigen;
+using namespace fasst;
+
+// XML description of a source of some rank, whose convolutive mixing
+// parameters are complex. The mixing parameters are multiplied by gain.
+static string source(int I, int rank, int F, int N, bool conv, int j,
+                     double gain) {
+  unsigned seed = 7 * j + 3;
+  stringstream s;
+  s << "<source><A adaptability=\"free\" mixing_type=\""
+    << (conv ? "conv" : "inst") << "\">";
+  s << "<ndims>" << (conv ? 3 : 2) << "</ndims><dim>" << I << "</dim><dim>"
+    << rank << "</dim>";
+  if (conv) {
+    s << "<dim>" << F << "</dim>";
+  }
+  s << "<type>" << (conv ? "complex" : "real") << "</type><data>";
+  for (int k = 0; k < I * rank * (conv ? 2 * F : 1); k++) {
+    s << (benchRandom(seed) - 0.6) * gain << ' ';
+  }
+  s << "</data></A>";
+  s << benchNonNegMatrix("Wex", F, 3, "free");
+  s << "<Uex adaptability=\"fixed\"><rows>3</rows><cols>3</cols>"
+       "<data>eye</data></Uex>";
+  s << "<Gex adaptability=\"fixed\"><rows>3</rows><cols>3</cols>"
+       "<data>eye</data></Gex>";
+  s << benchNonNegMatrix("Hex", 3, N, "free");
+  s << "</source>";
+  return s.str();
+}
+
+// Sources of the given ranks
+static Sources sources(int I, const vector<int> &ranks, int F, int N,
+                       bool conv, double gain = 1) {
+  string str = "<sources>";
+  for (size_t j = 0; j < ranks.size(); j++) {
+    str += source(I, ranks[j], F, N, conv, j, gain);
+  }
+  str += "</sources>";
+  QDomDocument doc;
+  doc.setContent(QString::fromStdString(str));
+  return Sources(doc.elementsByTagName("source"));
+}
+
+// Noise covariance s * I in every bin
+static VectorMatrixXcd scaledIdentity(int I, int F, double s) {
+  VectorMatrixXcd Sigma_b(F);
+  for (int f = 0; f < F; f++) {
+    Sigma_b(f) = MatrixXcd::Identity(I, I) * s;
+  }
+  return Sigma_b;
+}
+
+// Hermitian positive definite noise covariance which is not a scaled identity
+static VectorMatrixXcd generalNoise(int I, int F) {
+  unsigned seed = 5;
+  VectorMatrixXcd Sigma_b(F);
+  for (int f = 0; f < F; f++) {
+    MatrixXcd B(I, I);
+    for (int i = 0; i < I; i++) {
+      for (int k = 0; k < I; k++) {
+        B(i, k) = complex<double>(benchRandom(seed) - 0.6,
+                                  benchRandom(seed) - 0.6);
+      }
+    }
+    Sigma_b(f) = 0.01 * B * B.adjoint() + 0.01 * MatrixXcd::Identity(I, I);
+  }
+  return Sigma_b;
+}
+
+// Sigma_s of a TF point: Eq. 25
+static DiagonalMatrixXd denseSigmaS(const Sources &sources, int f, int n) {
+  DiagonalMatrixXd Sigma_s(sources.A(0).cols());
+  int r = 0;
+  for (int j = 0; j < sources.size(); j++) {
+    for (int k = 0; k < sources[j].rank(); k++) {
+      Sigma_s.diagonal()(r++) = sources[j].V(f, n);
+    }
+  }
+  return Sigma_s;
+}
+
+// Sigma_x of a TF point: Eq. 24
+static MatrixXcd denseSigmaX(const Sources &sources,
+                             const VectorMatrixXcd &Sigma_b, int f, int n) {
+  const MatrixXcd &A = sources.A(f);
+  return A * denseSigmaS(sources, f, n) * A.adjoint() + Sigma_b(f);
+}
+
+// Checks the statistics against Eq. 16 and Eq. 21 to 23, Sigma_x being
+// inverted
+static void expectDense(const Sources &sources, const MixCovMatrix &hatRx,
+                        const VectorMatrixXcd &Sigma_b) {
+  NaturalStatistics stats(sources, hatRx, Sigma_b);
+  int F = hatRx.bins();
+  int N = hatRx.frames();
+  int R = sources.A(0).cols();
+  double log_like = 0;
+  for (int f = 0; f < F; f++) {
+    for (int n = 0; n < N; n++) {
+      const MatrixXcd &A = sources.A(f);
+      DiagonalMatrixXd Sigma_s = denseSigmaS(sources, f, n);
+      MatrixXcd Sigma_x = denseSigmaX(sources, Sigma_b, f, n);
+      MatrixXcd Sigma_x_inverse = Sigma_x.inverse();
+      MatrixXcd Omega_s = Sigma_s * A.adjoint() * Sigma_x_inverse;
+      MatrixXcd hatRs = Omega_s * hatRx(f, n) * Omega_s.adjoint() +
+                        (MatrixXcd::Identity(R, R) - Omega_s * A) * Sigma_s;
+      MatrixXcd hatRxs = hatRx(f, n) * Omega_s.adjoint();
+      EXPECT_LT((stats.hatRs(f, n) - hatRs).norm(), 1e-9 * hatRs.norm());
+      EXPECT_LT((stats.hatRxs(f, n) - hatRxs).norm(), 1e-9 * hatRxs.norm());
+
+      // Eq. 16
+      log_like -= (Sigma_x_inverse * hatRx(f, n)).trace().real() +
+                  log(Sigma_x.determinant().real()) + log(M_PI);
+    }
+  }
+  log_like /= F * N;
+  EXPECT_NEAR(log_like, stats.logLikelihood(), 1e-9 * abs(log_like));
+}
+
+TEST(NaturalStatistics, General) {
+  int F = 9, N = 5;
+  MixCovMatrix hatRx(benchTFRepr(4, F, N));
+
+  // More sources than channels
+  vector<int> ranks(3, 2);
+  ranks[2] = 1;
+  expectDense(sources(4, ranks, F, N, true), hatRx,
+              scaledIdentity(4, F, 0.01));
+
+  // Fewer sources than channels, but a noise which is not a scaled identity
+  ranks.resize(2);
+  ranks[1] = 1;
+  expectDense(sources(4, ranks, F, N, true), hatRx, generalNoise(4, F));
+}
+
+TEST(NaturalStatistics, Determinant) {
+  // 8 channels, Sigma_x and hatRx being scaled by c, so that the determinant
+  // of Sigma_x underflows or overflows. The log-likelihood is shifted by
+  // -I * log(c).
+  int I = 8, F = 5, N = 3;
+  MixCovMatrix hatRx(benchTFRepr(I, F, N));
+  vector<int> ranks(2, 2);
+  VectorMatrixXcd Sigma_b = generalNoise(I, F);
+  double log_like = NaturalStatistics(sources(I, ranks, F, N, true), hatRx,
+                                      Sigma_b).logLikelihood();
+  double c[] = {1e-60, 1e60};
+  for (int k = 0; k < 2; k++) {
+    Sources s = sources(I, ranks, F, N, true, sqrt(c[k]));
+    MixCovMatrix hatRx_c(hatRx);
+    VectorMatrixXcd Sigma_b_c(F);
+    for (int f = 0; f < F; f++) {
+      Sigma_b_c(f) = Sigma_b(f) * c[k];
+      for (int n = 0; n < N; n++) {
+        hatRx_c(f, n) *= c[k];
+      }
+    }
+    double det = denseSigmaX(s, Sigma_b_c, 0, 0).determinant().real();
+    EXPECT_FALSE(std::isnormal(det));
+
+    double expected = log_like - I * log(c[k]);
+    EXPECT_NEAR(expected,
+                NaturalStatistics(s, hatRx_c, Sigma_b_c).logLikelihood(),
+                1e-9 * abs(expected));
+  }
+}
+
+TEST(NaturalStatistics, LowRank) {
+  // Fewer sources than channels and a scaled identity noise
+  int F = 9, N = 5;
+  MixCovMatrix hatRx(benchTFRepr(4, F, N));
+  vector<int> ranks(2, 1);
+  ranks[1] = 2;
+  expectDense(sources(4, ranks, F, N, true), hatRx,
+              scaledIdentity(4, F, 0.01));
+}
+
+TEST(NaturalStatistics, Stereo) {
+  // 13 bins, so that the last block of bins is incomplete
+  int F = 13, N = 5;
+  MixCovMatrix hatRx(benchTFRepr(2, F, N));
+  vector<int> ranks(3, 1);
+  ranks[1] = 2;
+  expectDense(sources(2, ranks, F, N, true), hatRx,
+              scaledIdentity(2, F, 0.01));
+  expectDense(sources(2, ranks, F, N, true), hatRx, generalNoise(2, F));
+}
+
+TEST(NaturalStatistics, MixingType) {
+  // Instantaneous and convolutive mixing, with fewer and more sources than
+  // channels
+  int F = 9, N = 5;
+  MixCovMatrix hatRx(benchTFRepr(3, F, N));
+  for (int conv = 0; conv < 2; conv++) {
+    for (int R = 2; R <= 4; R += 2) {
+      vector<int> ranks(2, R / 2);
+      Sources s = sources(3, ranks, F, N, conv);
+      for (int j = 0; j < s.size(); j++) {
+        EXPECT_EQ(s[j].isInst(), !conv);
+        for (int f = 0; f < F; f++) {
+          const MatrixXcd &A = s[j].A(conv ? f : 0);
+          EXPECT_LT((s[j].R(f) - A * A.adjoint()).norm(),
+                    1e-12 * s[j].R(f).norm());
+        }
+      }
+      expectDense(s, hatRx, scaledIdentity(3, F, 0.01));
+      expectDense(s, hatRx, generalNoise(3, F));
+    }
+  }
+
+  // Instantaneous stereo mixing
+  MixCovMatrix hatRx2(benchTFRepr(2, F, N));
+  vector<int> ranks(3, 1);
+  expectDense(sources(2, ranks, F, N, false), hatRx2,
+              scaledIdentity(2, F, 0.01));
+}
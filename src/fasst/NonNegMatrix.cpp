@@ -6,7 +6,10 @@ using namespace std;
 using namespace Eigen;
 
 namespace fasst {
-NonNegMatrix::NonNegMatrix(QDomElement el) {
+// Largest fraction of nonzero coefficients for which a sparse copy is kept
+static const double SPARSE_DENSITY = 0.1;
+
+NonNegMatrix::NonNegMatrix(QDomElement el) : m_online(false) {
   // Read attributes
   m_adaptability = el.attribute("adaptability").toLocal8Bit().constData();
 
@@ -50,12 +53,49 @@ void NonNegMatrix::replace(QDomDocument doc, QDomElement el) const {
   el.replaceChild(newNode, oldNode);
 }
 
+void NonNegMatrix::startOnline() {
+  m_online = true;
+  m_pastNum = ArrayXXd::Zero(rows(), cols());
+  m_pastDenom = ArrayXXd::Zero(rows(), cols());
+}
+
+void NonNegMatrix::commit(double forgetting) {
+  if (m_online && m_num.size() > 0) {
+    m_pastNum = forgetting * (m_pastNum + m_num);
+    m_pastDenom = forgetting * (m_pastDenom + m_denom);
+    m_num.resize(0, 0);
+    m_denom.resize(0, 0);
+  }
+}
+
+void NonNegMatrix::compSparse() {
+  if (isEye() || size() == 0 ||
+      (array() != 0).count() > SPARSE_DENSITY * size()) {
+    m_sparse.resize(0, 0);
+  } else {
+    m_sparse = sparseView();
+  }
+}
+
+void NonNegMatrix::multiply(const ArrayXXd &num, const ArrayXXd &denom) {
+  if (!m_online) {
+    _set(this->array() * (num / denom));
+    return;
+  }
+
+  // The numerator is weighted by the current value so that the statistics of
+  // the previous blocks, computed with other values, can be added to it
+  m_num = this->array() * num;
+  m_denom = denom;
+  _set((m_pastNum + m_num) / (m_pastDenom + m_denom));
+}
+
 void W::update(const ArrayXXd &Xi, const NonNegMatrix &D) {
   NonNegMatrix Dtranspose = D.transpose();
   ArrayXXd CD = (*this) * D;
   ArrayXXd num = NonNegMatrix(Xi / (CD * CD)) * Dtranspose;
   ArrayXXd denom = NonNegMatrix(1 / CD) * Dtranspose;
-  _set(this->array() * (num / denom));
+  multiply(num, denom);
 }
 
 void W::update(const ArrayXXd &Xi, const NonNegMatrix &D, const ArrayXXd &E) {
@@ -63,7 +103,7 @@ void W::update(const ArrayXXd &Xi, const NonNegMatrix &D, const ArrayXXd &E) {
   ArrayXXd CDE = ((*this) * D).array() * E;
   ArrayXXd num = NonNegMatrix(Xi * E / (CDE * CDE)) * Dtranspose;
   ArrayXXd denom = NonNegMatrix(E / CDE) * Dtranspose;
-  _set(this->array() * (num / denom));
+  multiply(num, denom);
 }
 
 void UG::update(const ArrayXXd &Xi, const NonNegMatrix &B, const NonNegMatrix &D) {
@@ -72,7 +112,8 @@ void UG::update(const ArrayXXd &Xi, const NonNegMatrix &B, const NonNegMatrix &D
   ArrayXXd BCD = B * (*this) * D;
   ArrayXXd num = Btranspose * NonNegMatrix(Xi / (BCD * BCD)) * Dtranspose;
   ArrayXXd denom = Btranspose * NonNegMatrix(1 / BCD) * Dtranspose;
-  _set(this->array() * (num / denom));
+  multiply(num, denom);
+  compSparse();
 }
 
 void UG::update(const ArrayXXd &Xi, const NonNegMatrix &B, const NonNegMatrix &D,
@@ -82,7 +123,8 @@ void UG::update(const ArrayXXd &Xi, const NonNegMatrix &B, const NonNegMatrix &D
   ArrayXXd BCDE = (B * (*this) * D).array() * E;
   ArrayXXd num = Btranspose * NonNegMatrix(Xi * E / (BCDE * BCDE)) * Dtranspose;
   ArrayXXd denom = Btranspose * NonNegMatrix(E / BCDE) * Dtranspose;
-  _set(this->array() * (num / denom));
+  multiply(num, denom);
+  compSparse();
 }
 
 void H::update(const ArrayXXd &Xi, const NonNegMatrix &B) {
@@ -90,7 +132,7 @@ void H::update(const ArrayXXd &Xi, const NonNegMatrix &B) {
   ArrayXXd BC = B * (*this);
   ArrayXXd num = Btranspose * NonNegMatrix(Xi / (BC * BC));
   ArrayXXd denom = Btranspose * NonNegMatrix(1 / BC);
-  _set(this->array() * (num / denom));
+  multiply(num, denom);
 }
 
 void H::update(const ArrayXXd &Xi, const NonNegMatrix &B, const ArrayXXd &E) {
@@ -98,6 +140,22 @@ void H::update(const ArrayXXd &Xi, const NonNegMatrix &B, const ArrayXXd &E) {
   ArrayXXd BCE = (B * (*this)).array() * E;
   ArrayXXd num = Btranspose * NonNegMatrix(Xi * E / (BCE * BCE));
   ArrayXXd denom = Btranspose * NonNegMatrix(E / BCE);
-  _set(this->array() * (num / denom));
+  multiply(num, denom);
+}
+
+void H::resizeFrames(int frames) {
+  int previous = static_cast<int>(cols());
+  conservativeResize(NoChange, frames);
+  for (int n = previous; n < frames; n++) {
+    col(n) = col(previous - 1);
+  }
+}
+
+void H::selectFrames(int first, int frames) {
+  _set(MatrixXd(middleCols(first, frames)));
+}
+
+void H::replaceFrames(const H &block, int first) {
+  middleCols(first, block.cols()) = block;
 }
 }
@@ -3,6 +3,7 @@
 
 #include "Parameter.h"
 #include <Eigen/Core>
+#include <Eigen/SparseCore>
 #include <QtXml/QDomElement>
 
 namespace fasst {
@@ -13,6 +14,10 @@ namespace fasst {
  subclass are able to update themself during the M-step of the EM algorithm.
 
  In case the matrix is not defined in XML, the m_eye flag is set to true and the matrix behaves like an identity matrix. We implement multiplication and transpose operations to avoid wasting time doing operations on identity matrices.
+
+ A matrix with few nonzero coefficients, such as a banded U or G, may also keep
+ a sparse copy of itself, which is then used by the multiplication. As the
+ multiplicative updates keep the zeros, the copy keeps the same structure.
      */
 class NonNegMatrix : public Parameter, public Eigen::MatrixXd {
 public:
@@ -26,7 +31,8 @@ public:
   /*!
    Kind of copy constructor to create NonNegMatrix from the result of an operation on MatrixXd.
    */
-  NonNegMatrix(const Eigen::MatrixXd &m) : Eigen::MatrixXd(m), m_eye(false) {}
+  NonNegMatrix(const Eigen::MatrixXd &m)
+      : Eigen::MatrixXd(m), m_eye(false), m_online(false) {}
 
   /*!
    This method creates a new XML element with the object data and replaces the
@@ -41,6 +47,12 @@ public:
       return rhs;
     } else if (rhs.isEye()) {
       return *this;
+    } else if (isSparse()) {
+      return NonNegMatrix(Eigen::MatrixXd(
+          m_sparse * static_cast<const Eigen::MatrixXd &>(rhs)));
+    } else if (rhs.isSparse()) {
+      return NonNegMatrix(Eigen::MatrixXd(
+          static_cast<const Eigen::MatrixXd &>(*this) * rhs.m_sparse));
     } else {
       return NonNegMatrix(Eigen::MatrixXd::operator*(rhs));
     }
@@ -50,14 +62,59 @@ public:
     if (isEye()) {
       return *this;
     } else {
-      return NonNegMatrix(Eigen::MatrixXd::transpose());
+      NonNegMatrix t(Eigen::MatrixXd::transpose());
+      if (isSparse()) {
+        t.m_sparse = m_sparse.transpose();
+      }
+      return t;
     }
   }
 
   inline bool isEye() const { return m_eye; }
 
+  /*!
+   \return true if the matrix keeps a sparse copy of itself
+   */
+  inline bool isSparse() const { return m_sparse.nonZeros() > 0; }
+
+  /*!
+   This method enables the online EM algorithm: from now on, each update also
+   uses the statistics of the previous blocks of frames, which are accumulated
+   by the commit method.
+   */
+  void startOnline();
+
+  /*!
+   This method adds the statistics of the last update to the statistics of the
+   previous blocks, and weights them by a forgetting factor, so that the next
+   block of frames is estimated with them.
+   \param forgetting the forgetting factor, between 0 and 1
+   */
+  void commit(double forgetting);
+
+protected:
+  /*!
+   This method applies a multiplicative update. With the online EM algorithm,
+   the numerator and the denominator of the previous blocks are added to the
+   ones of the current block.
+   \param num the numerator of the update
+   \param denom the denominator of the update
+   */
+  void multiply(const Eigen::ArrayXXd &num, const Eigen::ArrayXXd &denom);
+
+  /*!
+   This method keeps a sparse copy of the matrix if few of its coefficients
+   are nonzero, and drops it otherwise. It must be called again each time the
+   coefficients change.
+   */
+  void compSparse();
+
 private:
+  Eigen::SparseMatrix<double> m_sparse;
   bool m_eye;
+  bool m_online;
+  Eigen::ArrayXXd m_num, m_denom;
+  Eigen::ArrayXXd m_pastNum, m_pastDenom;
 };
 
 /*!
@@ -92,10 +149,10 @@ public:
 class UG : public NonNegMatrix {
 public:
   /*!
-   The main constructor of the class just calls NonNegMatrix::NonNegMatrix
-   constructor
+   The main constructor of the class calls NonNegMatrix::NonNegMatrix
+   constructor, then keeps a sparse copy of the matrix if it is sparse
    */
-  UG(QDomElement el) : NonNegMatrix(el) {}
+  UG(QDomElement el) : NonNegMatrix(el) { compSparse(); }
 
   /*!
    This method updates the data during the EM algorithm. It is a implementation
@@ -138,6 +195,28 @@ public:
    */
   void update(const Eigen::ArrayXXd &Xi, const NonNegMatrix &B,
               const Eigen::ArrayXXd &E);
+
+  /*!
+   This method changes the number of time frames. The first frames are kept
+   and the new ones are copies of the last frame.
+   \param frames the number of time frames
+   */
+  void resizeFrames(int frames);
+
+  /*!
+   This method only keeps some consecutive time frames.
+   \param first the index of the first time frame to be kept
+   \param frames the number of time frames to be kept
+   */
+  void selectFrames(int first, int frames);
+
+  /*!
+   This method replaces some consecutive time frames with the ones of another
+   H, which has been selected from this one by selectFrames.
+   \param block the new values of the time frames
+   \param first the index of the first time frame to be replaced
+   */
+  void replaceFrames(const H &block, int first);
 };
 }
 
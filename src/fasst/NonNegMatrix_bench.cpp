@@ -0,0 +1,130 @@
+#include "NonNegMatrix.h"
+#include "bench.h"
+#include <benchmark/benchmark.h>
+
+using namespace fasst;
+
+// Sweeps the NMF rank, the number of bins and the number of frames
+static void ranksBinsAndFrames(benchmark::internal::Benchmark *b) {
+  for (int K = 4; K <= 64; K *= 4) {
+    for (int F = 257; F <= 1025; F = F * 2 - 1) {
+      for (int N = 250; N <= 1000; N *= 2) {
+        b->Args({K, F, N});
+      }
+    }
+  }
+}
+
+// The W, U, G and H factors of a spectral power, with the statistics Xi and
+// the filter part E they are updated with
+class Factors {
+public:
+  Factors(int K, int F, int N)
+      : m_doc(document(K, F, N)), Wex(element("Wex")), Uex(element("Uex")),
+        Gex(element("Gex")), Hex(element("Hex")), Xi(F, N), E(F, N) {
+    unsigned seed = 1;
+    for (int n = 0; n < N; n++) {
+      for (int f = 0; f < F; f++) {
+        Xi(f, n) = benchRandom(seed);
+        E(f, n) = benchRandom(seed);
+      }
+    }
+  }
+
+private:
+  static QDomDocument document(int K, int F, int N) {
+    QDomDocument doc;
+    doc.setContent(QString::fromStdString(
+        "<source>" + benchNonNegMatrix("Wex", F, K, "free") +
+        benchNonNegMatrix("Uex", K, K, "free") +
+        benchNonNegMatrix("Gex", K, K, "free") +
+        benchNonNegMatrix("Hex", K, N, "free") + "</source>"));
+    return doc;
+  }
+
+  QDomElement element(const char *tag) const {
+    return m_doc.documentElement().firstChildElement(tag);
+  }
+
+  QDomDocument m_doc;
+
+public:
+  W Wex;
+  UG Uex;
+  UG Gex;
+  H Hex;
+  Eigen::ArrayXXd Xi;
+  Eigen::ArrayXXd E;
+};
+
+static void NonNegMatrix_updateW(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix UGH = p.Uex * p.Gex * p.Hex;
+  while (state.KeepRunning()) {
+    p.Wex.update(p.Xi, UGH);
+  }
+}
+BENCHMARK(NonNegMatrix_updateW)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateWFilter(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix UGH = p.Uex * p.Gex * p.Hex;
+  while (state.KeepRunning()) {
+    p.Wex.update(p.Xi, UGH, p.E);
+  }
+}
+BENCHMARK(NonNegMatrix_updateWFilter)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateU(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix GH = p.Gex * p.Hex;
+  while (state.KeepRunning()) {
+    p.Uex.update(p.Xi, p.Wex, GH);
+  }
+}
+BENCHMARK(NonNegMatrix_updateU)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateUFilter(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix GH = p.Gex * p.Hex;
+  while (state.KeepRunning()) {
+    p.Uex.update(p.Xi, p.Wex, GH, p.E);
+  }
+}
+BENCHMARK(NonNegMatrix_updateUFilter)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateG(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix WU = p.Wex * p.Uex;
+  while (state.KeepRunning()) {
+    p.Gex.update(p.Xi, WU, p.Hex);
+  }
+}
+BENCHMARK(NonNegMatrix_updateG)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateGFilter(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix WU = p.Wex * p.Uex;
+  while (state.KeepRunning()) {
+    p.Gex.update(p.Xi, WU, p.Hex, p.E);
+  }
+}
+BENCHMARK(NonNegMatrix_updateGFilter)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateH(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix WUG = p.Wex * p.Uex * p.Gex;
+  while (state.KeepRunning()) {
+    p.Hex.update(p.Xi, WUG);
+  }
+}
+BENCHMARK(NonNegMatrix_updateH)->Apply(ranksBinsAndFrames);
+
+static void NonNegMatrix_updateHFilter(benchmark::State &state) {
+  Factors p(state.range(0), state.range(1), state.range(2));
+  NonNegMatrix WUG = p.Wex * p.Uex * p.Gex;
+  while (state.KeepRunning()) {
+    p.Hex.update(p.Xi, WUG, p.E);
+  }
+}
+BENCHMARK(NonNegMatrix_updateHFilter)->Apply(ranksBinsAndFrames);
@@ -1,5 +1,6 @@
 #include "NonNegMatrix.h"
 #include <stdexcept>
+#include <sstream>
 #include <QDomDocument>
 #include "gtest/gtest.h"
 
@@ -29,3 +30,33 @@ TEST(NonNegMatrix, ReadWrite) {
     }
   }
 }
+
+TEST(NonNegMatrix, SparseProduct) {
+  // A bidiagonal 20 x 20 matrix, which is sparse
+  stringstream str;
+  str << "<mat adaptability=\"fixed\">"
+         "<rows>20</rows>"
+         "<cols>20</cols>"
+         "<data>";
+  for (int i = 0; i < 20; i++) {
+    for (int j = 0; j < 20; j++) {
+      str << (j == i ? 2. : (j == i + 1 ? 1. : 0.)) << ' ';
+    }
+    str << '\n';
+  }
+  str << "</data></mat>";
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(QString::fromStdString(str.str())));
+  UG band(doc.firstChild().toElement());
+  ASSERT_TRUE(band.isSparse());
+
+  // The products with its sparse copy are the dense products
+  Eigen::MatrixXd dense = Eigen::MatrixXd::Random(20, 3).cwiseAbs();
+  NonNegMatrix mat(dense);
+  Eigen::MatrixXd expected = static_cast<Eigen::MatrixXd>(band) * dense;
+  Eigen::MatrixXd actual = band * mat;
+  ASSERT_TRUE(actual.isApprox(expected));
+  expected = dense.transpose() * static_cast<Eigen::MatrixXd>(band);
+  actual = mat.transpose() * band;
+  ASSERT_TRUE(actual.isApprox(expected));
+}
@@ -0,0 +1,29 @@
+#include "OnlineGEM.h"
+#include "Sources.h"
+#include "MixCovMatrix.h"
+#include "GEM.h"
+
+namespace fasst {
+OnlineGEM::OnlineGEM(Sources &sources, int iterations, double forgetting)
+    : m_sources(sources), m_iterations(iterations), m_forgetting(forgetting),
+      m_blocks(0) {
+  m_sources.startOnline();
+}
+
+double OnlineGEM::next(const MixCovMatrix &hatRx) {
+  if (hatRx.frames() != m_sources.frames()) {
+    m_sources.resizeFrames(hatRx.frames());
+  }
+
+  // The noise is annealed on each block
+  GEM gem(m_sources, hatRx, m_iterations);
+  double log_like = 0;
+  for (int iter = 0; iter < m_iterations; iter++) {
+    log_like = gem.next();
+  }
+
+  m_sources.commit(m_forgetting);
+  m_blocks++;
+  return log_like;
+}
+}
@@ -0,0 +1,54 @@
+#ifndef FASST_ONLINEGEM_H
+#define FASST_ONLINEGEM_H
+
+namespace fasst {
+class Sources;
+class MixCovMatrix;
+
+/*!
+ This class runs the online variant of the generalized EM algorithm, which
+ estimates the parameters of some sources block of frames by block of frames,
+ so that the mixture covariance matrices of a long signal never have to be held
+ in memory. Each block is estimated with several GEM iterations where the
+ activations are only estimated on the block, while the mixing parameters and
+ the other spectral parameters also use the statistics of the previous blocks,
+ weighted by a forgetting factor.
+ */
+class OnlineGEM {
+public:
+  /*!
+   The main constructor of the class enables the online EM algorithm on the
+   sources, see Sources::startOnline.
+   \param sources the sources to be estimated
+   \param iterations the number of GEM iterations on each block
+   \param forgetting the forgetting factor between 0 and 1: with 1, every frame
+   has the same weight, with smaller values, the parameters follow the recent
+   frames
+   */
+  OnlineGEM(Sources &sources, int iterations, double forgetting);
+
+  /*!
+   This method estimates the parameters on the next block of frames. The
+   activations of the sources are resized to the number of frames of the block
+   if needed, and start from the ones of the previous block. Please note that
+   if the dimensions of the sources and of the block are not consistent, the
+   method will throw a `runtime_error` exception.
+   \param hatRx the mixture covariance matrices of the block
+   \return the log-likelihood of the block before the last update
+   */
+  double next(const MixCovMatrix &hatRx);
+
+  /*!
+   \return the number of blocks already estimated
+   */
+  inline int blocks() const { return m_blocks; }
+
+private:
+  Sources &m_sources;
+  int m_iterations;
+  double m_forgetting;
+  int m_blocks;
+};
+}
+
+#endif
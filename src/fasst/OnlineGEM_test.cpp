@@ -0,0 +1,56 @@
+#include "OnlineGEM.h"
+#include "GEM.h"
+#include "MixCovMatrix.h"
+#include "Sources.h"
+#include "bench.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace fasst;
+
+TEST(OnlineGEM, SingleBlock) {
+  // With a single block and no forgetting, the online algorithm runs the same
+  // iterations as the GEM algorithm
+  Audio x = benchAudio(4096, 2);
+  TFRepr X(x, 256);
+  MixCovMatrix hatRx(X);
+  string str = "<sources>";
+  for (int j = 0; j < 2; j++) {
+    str += benchSource(2, 3, X.bins(), X.frames(), true, j);
+  }
+  str += "</sources>";
+  QDomDocument batchDoc, onlineDoc;
+  ASSERT_TRUE(batchDoc.setContent(QString::fromStdString(str)));
+  ASSERT_TRUE(onlineDoc.setContent(QString::fromStdString(str)));
+  Sources batch(batchDoc.elementsByTagName("source"));
+  Sources online(onlineDoc.elementsByTagName("source"));
+
+  GEM gem(batch, hatRx, 3);
+  double log_like = 0;
+  for (int iter = 0; iter < 3; iter++) {
+    log_like = gem.next();
+  }
+  OnlineGEM onlineGEM(online, 3, 1.);
+  EXPECT_NEAR(log_like, onlineGEM.next(hatRx), 1e-9 * abs(log_like));
+  EXPECT_EQ(1, onlineGEM.blocks());
+
+  // GEM only updates the global mixing parameters
+  batch.syncMixingParameter();
+  online.syncMixingParameter();
+  batch.compV();
+  online.compV();
+  for (int j = 0; j < 2; j++) {
+    for (int f = 0; f < X.bins(); f++) {
+      EXPECT_LT((online[j].A(f) - batch[j].A(f)).norm(),
+                1e-9 * batch[j].A(f).norm());
+    }
+    EXPECT_LT((online[j].V() - batch[j].V()).abs().maxCoeff(),
+              1e-9 * batch[j].V().maxCoeff());
+  }
+
+  // Hence the same XML documents
+  batch.replace(batchDoc, batchDoc.elementsByTagName("source"));
+  online.replace(onlineDoc, onlineDoc.elementsByTagName("source"));
+  EXPECT_EQ(batchDoc.toString(), onlineDoc.toString());
+}
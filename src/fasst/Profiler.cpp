@@ -0,0 +1,186 @@
+#include "Profiler.h"
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// When FASST_ALLOCATION_COUNT is defined, with the GNU C library, the
+// allocations are counted by wrapping malloc, calloc and realloc, which are
+// also used by Eigen and by operator new. The aligned allocation functions are
+// not counted. The wrappers replace the allocator of the whole process, so they
+// must not be built along with a sanitizer or another allocator.
+#if defined(__GLIBC__) && defined(FASST_ALLOCATION_COUNT)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+static bool g_counting = false;
+static long g_allocations = 0;
+static long g_allocatedBytes = 0;
+
+static inline void countAllocation(size_t size) {
+  if (g_counting) {
+    __atomic_fetch_add(&g_allocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_allocatedBytes, static_cast<long>(size),
+                       __ATOMIC_RELAXED);
+  }
+}
+
+extern "C" void *malloc(size_t size) __THROW {
+  countAllocation(size);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) __THROW {
+  countAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) __THROW {
+  countAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+static void startCounting() { g_counting = true; }
+static long allocations() {
+  return __atomic_load_n(&g_allocations, __ATOMIC_RELAXED);
+}
+static long allocatedBytes() {
+  return __atomic_load_n(&g_allocatedBytes, __ATOMIC_RELAXED);
+}
+#else
+static void startCounting() {}
+static long allocations() { return -1; }
+static long allocatedBytes() { return -1; }
+#endif
+
+// Peak resident memory in kB
+static long peakResidentMemory() {
+#if defined(__APPLE__)
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / 1024 : -1;
+#elif defined(__unix__)
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : -1;
+#else
+  return -1;
+#endif
+}
+
+namespace fasst {
+// Adds the statistics of some stages to others
+static void merge(map<string, Profiler::Stage> &total,
+                  const map<string, Profiler::Stage> &stages) {
+  for (map<string, Profiler::Stage>::const_iterator it = stages.begin();
+       it != stages.end(); ++it) {
+    total[it->first].calls += it->second.calls;
+    total[it->first].seconds += it->second.seconds;
+  }
+}
+
+Profiler &Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+    : m_enabled(false), m_out(0), m_iterations(0), m_allocations(0),
+      m_allocatedBytes(0) {
+  const char *fname = getenv("FASST_PROFILE");
+  if (fname == 0 || *fname == '\0') {
+    return;
+  }
+
+  // Open fname, - being the standard error
+  if (string(fname) == "-") {
+    m_out = &cerr;
+  } else {
+    m_file.open(fname);
+    if (!m_file.good()) {
+      stringstream s;
+      s << "Can not open " << fname << ". ";
+      s << "You probably don't have write access to this location.";
+      throw runtime_error(s.str());
+    }
+    m_out = &m_file;
+  }
+  m_out->precision(10);
+  m_enabled = true;
+  startCounting();
+}
+
+Profiler::~Profiler() {
+  if (!m_enabled) {
+    return;
+  }
+
+  // Stages which did not end with an iteration are only in the summary
+  merge(m_total, m_iteration);
+  *m_out << "{\"summary\": {\"iterations\": " << m_iterations << ", ";
+  write(m_total, allocations(), allocatedBytes());
+  *m_out << "}}" << endl;
+}
+
+void Profiler::add(const char *stage, double seconds) {
+#pragma omp critical(fasst_profiler)
+  {
+    Stage &s = m_iteration[stage];
+    s.calls++;
+    s.seconds += seconds;
+  }
+}
+
+void Profiler::iteration(double logLikelihood) {
+  if (!m_enabled) {
+    return;
+  }
+#pragma omp critical(fasst_profiler)
+  {
+    m_iterations++;
+    *m_out << "{\"iteration\": " << m_iterations
+           << ", \"log_likelihood\": " << logLikelihood << ", ";
+    long count = allocations();
+    long bytes = allocatedBytes();
+    write(m_iteration, count < 0 ? -1 : count - m_allocations,
+          bytes < 0 ? -1 : bytes - m_allocatedBytes);
+    *m_out << "}" << endl;
+    m_allocations = count;
+    m_allocatedBytes = bytes;
+    merge(m_total, m_iteration);
+    m_iteration.clear();
+  }
+}
+
+void Profiler::write(const Stages &stages, long count, long bytes) {
+  *m_out << "\"stages\": {";
+  for (Stages::const_iterator it = stages.begin(); it != stages.end(); ++it) {
+    if (it != stages.begin()) {
+      *m_out << ", ";
+    }
+    *m_out << '"' << it->first << "\": {\"calls\": " << it->second.calls
+           << ", \"seconds\": " << it->second.seconds << '}';
+  }
+  *m_out << "}, \"allocations\": " << count
+         << ", \"allocated_bytes\": " << bytes
+         << ", \"peak_rss_kb\": " << peakResidentMemory();
+}
+
+double Profiler::now() {
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+}
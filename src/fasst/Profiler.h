@@ -0,0 +1,120 @@
+#ifndef FASST_PROFILER_H
+#define FASST_PROFILER_H
+
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace fasst {
+
+/*!
+ This class gathers the time spent in each stage of the GEM algorithm, the
+ number of memory allocations and the peak resident memory. It is switched on
+ by setting the `FASST_PROFILE` environment variable to the name of a file, or
+ to `-` for the standard error. A JSON object is then written on its own line
+ at the end of each GEM iteration, and a summary at exit. Each iteration holds
+ the stages and allocations since the previous one, so the stages which come
+ before the first iteration, such as loading Rx, are counted in it.
+
+ When the variable is not set, timing a stage costs one test of a flag.
+
+ \remark The allocations are only counted with the GNU C library, when FASST
+ is configured with `-DALLOCATION_COUNT=ON`, and the peak resident memory is
+ only known on Unix systems. They are -1 otherwise.
+ */
+class Profiler {
+public:
+  /*!
+   \return the profiler of the process
+   */
+  static Profiler &get();
+
+  ~Profiler();
+
+  /*!
+   \return true if the profiler is switched on
+   */
+  inline bool enabled() const { return m_enabled; }
+
+  /*!
+   This method adds the time spent in a stage.
+   \param stage the name of the stage
+   \param seconds the elapsed time in seconds
+   */
+  void add(const char *stage, double seconds);
+
+  /*!
+   This method writes the statistics of the stages since the previous
+   iteration, then adds them to the summary.
+   \param logLikelihood the log-likelihood of the iteration
+   */
+  void iteration(double logLikelihood);
+
+  /*!
+   \return the current time in seconds
+   */
+  static double now();
+
+  /*!
+   The statistics of a stage.
+   */
+  struct Stage {
+    Stage() : calls(0), seconds(0) {}
+    int calls;
+    double seconds;
+  };
+
+private:
+  typedef std::map<std::string, Stage> Stages;
+
+  Profiler();
+  Profiler(const Profiler &);
+  Profiler &operator=(const Profiler &);
+
+  // Writes the stages and the memory counters as JSON members
+  void write(const Stages &stages, long count, long bytes);
+
+  bool m_enabled;
+  std::ofstream m_file;
+  std::ostream *m_out;
+  int m_iterations;
+  Stages m_iteration;
+  Stages m_total;
+  long m_allocations;
+  long m_allocatedBytes;
+};
+
+/*!
+ This class adds the time spent in its scope to a stage of the profiler.
+ */
+class ScopedTimer {
+public:
+  /*!
+   \param stage the name of the stage, which must outlive the timer
+   */
+  explicit ScopedTimer(const char *stage)
+      : m_stage(Profiler::get().enabled() ? stage : 0),
+        m_start(m_stage ? Profiler::now() : 0) {}
+
+  ~ScopedTimer() { stop(); }
+
+  /*!
+   This method ends the timing before the end of the scope.
+   */
+  inline void stop() {
+    if (m_stage) {
+      Profiler::get().add(m_stage, Profiler::now() - m_start);
+      m_stage = 0;
+    }
+  }
+
+private:
+  ScopedTimer(const ScopedTimer &);
+  ScopedTimer &operator=(const ScopedTimer &);
+
+  const char *m_stage;
+  double m_start;
+};
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef FASST_SERVERPROTOCOL_H
+#define FASST_SERVERPROTOCOL_H
+
+namespace fasst {
+
+/*!
+ This structure is sent by a client of the separation server, followed by the
+ mixture as `samples` times `channels` interleaved 32-bit floats.
+ */
+struct ServerRequest {
+  int model;
+  int channels;
+  int samples;
+  int samplerate;
+};
+
+/*!
+ This structure is sent back by the server. If the status is 0, it is followed
+ by `sources` ints giving the number of channels of each estimated source (the
+ number of channels of the mixture with the STFT, the rank of the source with
+ the ERB transform), then by the sources as `samples` times `channels` 32-bit
+ floats, where each sample holds the channels of the first source, then the
+ channels of the second source, and so on, and then by a ServerTrailer.
+ Otherwise, it is followed by an error message of `samples` characters.
+ */
+struct ServerResponse {
+  int status;
+  int sources;
+  /*!
+   The total number of channels of the sources
+   */
+  int channels;
+  int samples;
+};
+
+/*!
+ This structure ends a successful response of the server.
+ */
+struct ServerTrailer {
+  /*!
+   The time spent by the server between the request and the end of the
+   response, in microseconds
+   */
+  int latency;
+};
+}
+
+#endif
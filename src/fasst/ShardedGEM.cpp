@@ -0,0 +1,293 @@
+#include "ShardedGEM.h"
+#include "Sources.h"
+#include "MixCovMatrix.h"
+#include "NaturalStatistics.h"
+#include "GEM.h"
+#include "Threads.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace Eigen;
+
+namespace fasst {
+
+// Writes one command or result byte to a pipe
+static bool send(int fd, char c) {
+  ssize_t n;
+  do {
+    n = write(fd, &c, 1);
+  } while (n < 0 && errno == EINTR);
+  return n == 1;
+}
+
+// Reads one command or result byte from a pipe, or 0 if it has been closed
+static char receive(int fd) {
+  char c;
+  ssize_t n;
+  do {
+    n = read(fd, &c, 1);
+  } while (n < 0 && errno == EINTR);
+  return n == 1 ? c : 0;
+}
+
+ShardedGEM::ShardedGEM(Sources &sources, const char *fname, int iterations,
+                       int shards)
+    : m_sources(sources), m_fname(fname), m_iterations(iterations),
+      m_iteration(0), m_sigpipe(SIG_DFL), m_shared(MAP_FAILED),
+      m_sharedSize(0) {
+  // Check if dimensions are consistent
+  {
+    MixCovMatrixReader reader(fname);
+    if (reader.bins() != sources.bins() ||
+        reader.frames() != sources.frames() ||
+        reader.channels() != sources.channels()) {
+      stringstream s;
+      s << "Error:\tdimensions are not consistent:\n";
+      s << "F = " << reader.bins() << ", N = " << reader.frames()
+        << ", I = " << reader.channels() << " in Rx\n";
+      s << "F = " << sources.bins() << ", N = " << sources.frames()
+        << ", I = " << sources.channels() << " in sources\n";
+      throw runtime_error(s.str());
+    }
+  }
+  m_bins = sources.bins();
+  m_frames = sources.frames();
+  m_channels = sources.channels();
+  m_rank = static_cast<int>(sources.A(0).cols());
+  shards = std::max(1, std::min(shards, m_bins));
+
+  // Map the shared memory before the workers are forked
+  int F = m_bins, N = m_frames, I = m_channels, R = m_rank;
+  int J = sources.size();
+  size_t nA = static_cast<size_t>(F) * I * R;
+  size_t nSums = static_cast<size_t>(shards) * (I * R + R * R);
+  size_t nV = static_cast<size_t>(J) * F * N;
+  m_sharedSize = (nA + nSums) * sizeof(complex<double>) +
+                 (2 * nV + shards) * sizeof(double) + sizeof(int);
+  m_shared = mmap(0, m_sharedSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (m_shared == MAP_FAILED) {
+    stringstream s;
+    s << "Can not map " << m_sharedSize << " bytes of shared memory. "
+      << strerror(errno);
+    throw runtime_error(s.str());
+  }
+  m_sharedA = static_cast<complex<double> *>(m_shared);
+  m_sharedSums = m_sharedA + nA;
+  m_sharedV = reinterpret_cast<double *>(m_sharedSums + nSums);
+  m_sharedXi = m_sharedV + nV;
+  m_sharedLogLike = m_sharedXi + nV;
+  m_sharedIteration = reinterpret_cast<int *>(m_sharedLogLike + shards);
+
+  // A worker which failed has closed its pipes, writing to them must not kill
+  // the coordinator before it reports the error
+  m_sigpipe = signal(SIGPIPE, SIG_IGN);
+
+  // Start the workers, each on consecutive bins
+  for (int s = 0; s < shards; s++) {
+    Worker worker;
+    worker.first = s * F / shards;
+    worker.bins = (s + 1) * F / shards - worker.first;
+    int command[2], result[2];
+    if (pipe(command) < 0) {
+      stop();
+      throw runtime_error("Can not create a pipe.");
+    }
+    if (pipe(result) < 0) {
+      close(command[0]);
+      close(command[1]);
+      stop();
+      throw runtime_error("Can not create a pipe.");
+    }
+    worker.pid = fork();
+    if (worker.pid == 0) {
+      // The worker never returns to the caller
+      close(command[1]);
+      close(result[0]);
+      for (size_t w = 0; w < m_workers.size(); w++) {
+        close(m_workers[w].command);
+        close(m_workers[w].result);
+      }
+      worker.command = command[0];
+      worker.result = result[1];
+      m_workers.assign(1, worker);
+      int status = 0;
+      try {
+#ifdef _OPENMP
+        omp_set_num_threads(std::max(1, omp_get_num_procs() / shards));
+#endif
+        pinThreads(s, shards);
+        work(s);
+      } catch (const exception &e) {
+        cerr << "Shard " << s << ": " << e.what() << '\n';
+        send(worker.result, 'e');
+        status = 1;
+      }
+      _exit(status);
+    }
+    close(command[0]);
+    close(result[1]);
+    if (worker.pid < 0) {
+      close(command[1]);
+      close(result[0]);
+      stop();
+      throw runtime_error("Can not start a worker process.");
+    }
+    worker.command = command[1];
+    worker.result = result[0];
+    m_workers.push_back(worker);
+  }
+
+  // Wait for the workers to read their bins
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    if (receive(m_workers[w].result) != 'r') {
+      stop();
+      throw runtime_error("Error:\ta worker failed to load its bins.");
+    }
+  }
+}
+
+ShardedGEM::~ShardedGEM() { stop(); }
+
+void ShardedGEM::stop() {
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    send(m_workers[w].command, 'q');
+    close(m_workers[w].command);
+    close(m_workers[w].result);
+  }
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    waitpid(m_workers[w].pid, 0, 0);
+  }
+  m_workers.clear();
+  if (m_shared != MAP_FAILED) {
+    munmap(m_shared, m_sharedSize);
+    m_shared = MAP_FAILED;
+    signal(SIGPIPE, m_sigpipe);
+  }
+}
+
+double ShardedGEM::next() {
+  int F = m_bins, N = m_frames, I = m_channels, R = m_rank;
+  int J = m_sources.size();
+
+  // Publish the parameters
+  *m_sharedIteration = m_iteration;
+  for (int f = 0; f < F; f++) {
+    Map<MatrixXcd>(m_sharedA + f * I * R, I, R) = m_sources.A(f);
+  }
+  for (int j = 0; j < J; j++) {
+    Map<ArrayXXd>(m_sharedV + j * F * N, F, N) = m_sources[j].V();
+  }
+
+  // Run the E-step and Eq. 26 on every shard
+  ScopedTimer estep("estep");
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    send(m_workers[w].command, 'n');
+  }
+  bool failed = false;
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    failed |= receive(m_workers[w].result) != 'd';
+  }
+  if (failed) {
+    throw runtime_error("Error:\ta worker failed during an iteration.");
+  }
+  estep.stop();
+
+  // Reduce the statistics: Eq. 27 spans all the bins
+  for (int f = 0; f < F; f++) {
+    m_sources.setMixingParameter(f, Map<MatrixXcd>(m_sharedA + f * I * R, I, R));
+  }
+  int RI = 0;
+  for (int j = 0; j < J; j++) {
+    if (m_sources[j].A().isFree() && m_sources[j].isInst()) {
+      RI += m_sources[j].rank();
+    }
+  }
+  MatrixXcd sum = MatrixXcd::Zero(I, RI);
+  MatrixXcd sum_hat_Rs_I = MatrixXcd::Zero(RI, RI);
+  double log_like = 0;
+  for (size_t w = 0; w < m_workers.size(); w++) {
+    complex<double> *sums = m_sharedSums + w * (I * R + R * R);
+    sum += Map<MatrixXcd>(sums, I, RI);
+    sum_hat_Rs_I += Map<MatrixXcd>(sums + I * R, RI, RI);
+    log_like += m_sharedLogLike[w];
+  }
+  {
+    ScopedTimer mixing("mixing");
+    m_sources.solveInstantaneousMixing(sum, sum_hat_Rs_I);
+  }
+
+  // Update the spectral parameters from the Xi of all the bins
+  vector<ArrayXXd> Xi(J);
+  for (int j = 0; j < J; j++) {
+    Xi[j] = Map<ArrayXXd>(m_sharedXi + j * F * N, F, N);
+  }
+  m_sources.updateSpectralPower(Xi);
+
+  m_iteration++;
+  Profiler::get().iteration(log_like / (F * N));
+  return log_like / (F * N);
+}
+
+void ShardedGEM::work(int shard) {
+  const Worker &worker = m_workers[0];
+  int F = m_bins, N = m_frames, I = m_channels, R = m_rank;
+  int J = m_sources.size();
+  int first = worker.first;
+  int bins = worker.bins;
+
+  // The bins are read by the worker, so that their memory is local to it
+  MixCovMatrix hatRx(m_fname.c_str(), first, bins);
+  Sources sources = m_sources.selectBins(first, bins);
+  GEM gem(sources, hatRx, m_iterations);
+  send(worker.result, 'r');
+
+  while (receive(worker.command) == 'n') {
+    // Load the parameters of the bins
+    for (int f = 0; f < bins; f++) {
+      sources.setMixingParameter(
+          f, Map<MatrixXcd>(m_sharedA + (first + f) * I * R, I, R));
+    }
+    for (int j = 0; j < J; j++) {
+      sources.setSpectralPower(j, Map<ArrayXXd>(m_sharedV + j * F * N, F, N)
+                                      .middleRows(first, bins));
+    }
+
+    // E-step and Eq. 26
+    NaturalStatistics stats(sources, hatRx, gem.noise(*m_sharedIteration));
+    sources.updateConvolutiveMixing(stats);
+    MatrixXcd sum, sum_hat_Rs_I;
+    sources.sumInstantaneousMixing(stats, sum, sum_hat_Rs_I);
+    vector<ArrayXXd> Xi = sources.spectralStatistics(stats);
+
+    // Store the statistics of the bins
+    for (int f = 0; f < bins; f++) {
+      Map<MatrixXcd>(m_sharedA + (first + f) * I * R, I, R) = sources.A(f);
+    }
+    complex<double> *sums = m_sharedSums + shard * (I * R + R * R);
+    Map<MatrixXcd>(sums, I, sum.cols()) = sum;
+    Map<MatrixXcd>(sums + I * R, sum_hat_Rs_I.rows(), sum_hat_Rs_I.cols()) =
+        sum_hat_Rs_I;
+    for (int j = 0; j < J; j++) {
+      Map<ArrayXXd>(m_sharedXi + j * F * N, F, N).middleRows(first, bins) =
+          Xi[j];
+    }
+    m_sharedLogLike[shard] = stats.logLikelihood() * bins * N;
+    send(worker.result, 'd');
+  }
+}
+}
@@ -0,0 +1,104 @@
+#ifndef FASST_SHARDEDGEM_H
+#define FASST_SHARDEDGEM_H
+
+#include <complex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace fasst {
+class Sources;
+
+/*!
+ This class runs the generalized EM algorithm with the frequency bins split
+ between several worker processes, so that each worker only holds, and first
+ touches, the mixture covariance matrices of its own bins. Each iteration, the
+ workers compute the E-step and the convolutive mixing parameters (\ref eq
+ "Eq. 26") of their bins, which are independent from the other bins, and a
+ coordinator, which is the calling process, reduces the statistics which span
+ all the bins: it updates the instantaneous mixing parameters and the spectral
+ parameters. Parameters and statistics go through a shared memory mapping. It
+ is only available on Unix systems.
+ */
+class ShardedGEM {
+public:
+  /*!
+   The main constructor of the class starts the workers, which read their bins
+   of the mixture covariance matrices. It must be called before any OpenMP
+   parallel region of the calling process. `SIGPIPE` is ignored by the calling
+   process until the workers are stopped. Please note that if the file is not
+   readable or if its dimensions and the ones of the sources are not
+   consistent, the constructor will throw a `runtime_error` exception.
+   \param sources the sources to be estimated
+   \param fname the name of the binary file of the mixture covariance matrices
+   \param iterations the number of iterations
+   \param shards the number of worker processes
+   */
+  ShardedGEM(Sources &sources, const char *fname, int iterations, int shards);
+
+  /*!
+   The destructor stops the workers.
+   */
+  ~ShardedGEM();
+
+  /*!
+   This method runs the next iteration. Please note that if a worker fails, the
+   method will throw a `runtime_error` exception.
+   \return the log-likelihood before the update
+   */
+  double next();
+
+  /*!
+   \return the number of iterations already run
+   */
+  inline int iteration() const { return m_iteration; }
+
+  /*!
+   \return the total number of iterations
+   */
+  inline int iterations() const { return m_iterations; }
+
+private:
+  ShardedGEM(const ShardedGEM &);
+  ShardedGEM &operator=(const ShardedGEM &);
+
+  struct Worker {
+    pid_t pid;
+    int command;
+    int result;
+    int first;
+    int bins;
+  };
+
+  /*!
+   This method is the main loop of a worker process, which serves the
+   iterations until it is stopped.
+   */
+  void work(int shard);
+
+  /*!
+   This method stops the workers which have been started.
+   */
+  void stop();
+
+  Sources &m_sources;
+  std::string m_fname;
+  int m_iterations;
+  int m_iteration;
+  int m_bins, m_frames, m_channels, m_rank;
+  std::vector<Worker> m_workers;
+  void (*m_sigpipe)(int);
+
+  // Shared memory mapping
+  void *m_shared;
+  size_t m_sharedSize;
+  int *m_sharedIteration;
+  std::complex<double> *m_sharedA;
+  double *m_sharedV;
+  double *m_sharedXi;
+  std::complex<double> *m_sharedSums;
+  double *m_sharedLogLike;
+};
+}
+
+#endif
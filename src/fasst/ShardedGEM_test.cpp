@@ -0,0 +1,66 @@
+#include "ShardedGEM.h"
+#include "GEM.h"
+#include "MixCovMatrix.h"
+#include "Sources.h"
+#include "bench.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace fasst;
+
+TEST(ShardedGEM, GEM) {
+  // The workers are forked before any OpenMP thread is started
+#ifdef _OPENMP
+  int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  Audio x = benchAudio(4096, 2);
+  TFRepr X(x, 256);
+  MixCovMatrix(X).write("tmp_Rx.bin");
+
+  // A convolutive and an instantaneous source, whose mixing parameters are
+  // updated by the workers and by the coordinator
+  string str = "<sources>";
+  for (int j = 0; j < 2; j++) {
+    str += benchSource(2, 3, X.bins(), X.frames(), j == 0, j);
+  }
+  str += "</sources>";
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(QString::fromStdString(str)));
+  Sources sharded(doc.elementsByTagName("source"));
+  Sources batch(doc.elementsByTagName("source"));
+  ShardedGEM shardedGEM(sharded, "tmp_Rx.bin", 3, 3);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  // The bins are read from the file by the workers, as the whole mixture
+  // covariance matrices are by GEM
+  MixCovMatrix hatRx("tmp_Rx.bin");
+  GEM gem(batch, hatRx, 3);
+  for (int iter = 0; iter < 3; iter++) {
+    double log_like = gem.next();
+    EXPECT_NEAR(log_like, shardedGEM.next(), 1e-9 * abs(log_like));
+  }
+  EXPECT_EQ(3, shardedGEM.iteration());
+
+  // GEM only updates the global mixing parameters
+  batch.syncMixingParameter();
+  sharded.syncMixingParameter();
+  batch.compV();
+  sharded.compV();
+  for (int j = 0; j < 2; j++) {
+    int bins = batch[j].isConv() ? X.bins() : 1;
+    for (int f = 0; f < bins; f++) {
+      EXPECT_LT((sharded[j].A(f) - batch[j].A(f)).norm(),
+                1e-9 * batch[j].A(f).norm());
+    }
+    EXPECT_LT((sharded[j].V() - batch[j].V()).abs().maxCoeff(),
+              1e-9 * batch[j].V().maxCoeff());
+  }
+}
@@ -100,6 +100,20 @@ Source::Source(QDomNode node)
   compR();
 }
 
+Source::Source(const Source &source, int first, int frames)
+    : m_name(source.m_name), m_A(source.m_A), m_ex(source.m_ex),
+      m_ft(source.m_ft), m_excitationOnly(source.m_excitationOnly),
+      m_bins(source.m_bins), m_wiener_qa(source.m_wiener_qa),
+      m_wiener_b(source.m_wiener_b), m_wiener_c1(source.m_wiener_c1),
+      m_wiener_c2(source.m_wiener_c2), m_wiener_qd(source.m_wiener_qd),
+      m_R(source.m_R) {
+  m_ex.selectFrames(first, frames);
+  if (!m_excitationOnly) {
+    m_ft.selectFrames(first, frames);
+  }
+  compV();
+}
+
 void Source::replace(QDomDocument doc, QDomNode node) const {
   if (m_A.isFree()) {
     m_A.replace(doc, node.firstChildElement("A"));
@@ -115,17 +129,50 @@ void Source::updateSpectralPower(const ArrayXXd &Xi) {
   if (m_excitationOnly) {
     m_ex.update(Xi);
   } else {
-    ArrayXXd E;
-    E = m_ft.V();
-    m_ex.update(Xi, E);
+    m_ex.update(Xi, m_ft.V());
+    m_ft.update(Xi, m_ex.V());
+  }
+
+  compV();
+}
 
-    E = m_ex.V();
-    m_ft.update(Xi, E);
+void Source::startOnline() {
+  m_ex.startOnline();
+  if (!m_excitationOnly) {
+    m_ft.startOnline();
+  }
+}
+
+void Source::commit(double forgetting) {
+  m_ex.commit(forgetting);
+  if (!m_excitationOnly) {
+    m_ft.commit(forgetting);
   }
+}
 
+void Source::resizeFrames(int frames) {
+  m_ex.resizeFrames(frames);
+  if (!m_excitationOnly) {
+    m_ft.resizeFrames(frames);
+  }
   compV();
 }
 
+void Source::replaceFrames(const Source &block, int first) {
+  m_ex.replaceFrames(block.m_ex, first);
+  if (!m_excitationOnly) {
+    m_ft.replaceFrames(block.m_ft, first);
+  }
+}
+
+void Source::selectBins(int first, int bins) {
+  m_V = m_V.middleRows(first, bins).eval();
+  if (!isInst()) {
+    m_R = m_R.segment(first, bins).eval();
+  }
+  m_bins = bins;
+}
+
 void Source::compV() {
   if (m_excitationOnly) {
     m_V = m_ex.V();
@@ -135,12 +182,13 @@ void Source::compV() {
 }
 
 void Source::compR() {
-  m_R = VectorMatrixXcd(m_bins);
+  // With instantaneous mixing, R is the same for all the frequency bins and is
+  // stored once
   if (isInst()) {
-    for (int f = 0; f < m_bins; f++) {
-      m_R(f) = m_A(0) * m_A(0).adjoint();
-    }
+    m_R = VectorMatrixXcd(1);
+    m_R(0) = m_A(0) * m_A(0).adjoint();
   } else {
+    m_R = VectorMatrixXcd(m_bins);
     for (int f = 0; f < m_bins; f++) {
       m_R(f) = m_A(f) * m_A(f).adjoint();
     }
@@ -189,9 +237,15 @@ void Source::initSigmaY(){
     }
   }
 
+  // b * R only depends on the frequency bin
+  VectorMatrixXcd bR(m_R.size());
+  for (int f = 0; f < m_R.size(); f++) {
+    bR(f) = m_wiener_qa * b * m_R(f);
+  }
+
   for (int n = 0; n < frames(); n++) {
     for (int f = 0; f < m_bins; f++) {
-      m_Sigma_y(f,n) = m_wiener_qa * m_V(f, n) * b * m_R(f);
+      m_Sigma_y(f,n) = m_V(f, n) * bR(bR.size() == 1 ? 0 : f);
     }
   }
 }
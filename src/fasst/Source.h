@@ -23,6 +23,17 @@ public:
    */
   Source(QDomNode node);
 
+  /*!
+   This constructor copies the parameters of a source on some consecutive time
+   frames only, so that they can be estimated on these frames. Please note that
+   if the source has no activations, the constructor will throw a
+   `runtime_error` exception.
+   \param source the source to be copied
+   \param first the index of the first time frame
+   \param frames the number of time frames
+   */
+  Source(const Source &source, int first, int frames);
+
   /*!
    This method call the replace method on each parameter which degree of
    adaptability is free.
@@ -39,6 +50,36 @@ public:
    */
   void updateSpectralPower(const Eigen::ArrayXXd &Xi);
 
+  /*!
+   This method enables the online EM algorithm on the spectral parameters which
+   are shared by all the blocks of frames, see SpectralPower::startOnline.
+   */
+  void startOnline();
+
+  /*!
+   This method accumulates the statistics of the current block of frames, see
+   SpectralPower::commit.
+   \param forgetting the forgetting factor, between 0 and 1
+   */
+  void commit(double forgetting);
+
+  /*!
+   This method changes the number of time frames of the activations and
+   recomputes V. Please note that if the source has no activations, the method
+   will throw a `runtime_error` exception.
+   \param frames the number of time frames
+   */
+  void resizeFrames(int frames);
+
+  /*!
+   This method copies the spectral parameters shared by all the time frames
+   from a source built by Source(const Source &, int, int), and replaces its
+   time frames of the activations. V is not recomputed, see compV.
+   \param block the source estimated on the time frames
+   \param first the index of the first time frame
+   */
+  void replaceFrames(const Source &block, int first);
+
   /*!
    \return `true` is the mixing type of the source is instantaneous, `false` if
    it is convolutive.
@@ -99,19 +140,27 @@ public:
    */
   inline double V(int bin, int frame) const { return m_V(bin, frame); }
 
+  /*!
+   \return the \f$F \times N\f$-array of the spectral power `V`
+   */
+  inline const Eigen::ArrayXXd &V() const { return m_V; }
+
   /*!
    This method is used to get the spatial covariance matrix `R` in one frequency
-   bin.
+   bin. With instantaneous mixing, it is the same matrix for all the bins.
    \param bin the frequency bin index
    \return the matrix \f$R_{f}\f$ corresponding to the index.
    */
-  inline const Eigen::MatrixXcd &R(int bin) const { return m_R(bin); }
+  inline const Eigen::MatrixXcd &R(int bin) const {
+    return m_R(m_R.size() == 1 ? 0 : bin);
+  }
 
   /*!
    This method is used to get the covariance matrix `Sigma_y` in one time-frequency
    bin.
    */
   inline Eigen::MatrixXcd &Sigma_y(int bin, int frame) { return m_Sigma_y(bin,frame); }
+  inline const Eigen::MatrixXcd &Sigma_y(int bin, int frame) const { return m_Sigma_y(bin,frame); }
 
   /*!
    This method computes V. It is an implementation of \ref eq "Eq. 9". It is
@@ -119,6 +168,21 @@ public:
    */
   void compV();
 
+  /*!
+   This method sets V, which is otherwise computed from the spectral
+   parameters.
+   \param V the \f$F \times N\f$-array of the spectral power
+   */
+  inline void setV(const Eigen::ArrayXXd &V) { m_V = V; }
+
+  /*!
+   This method only keeps some consecutive frequency bins of V and R, see
+   Sources::selectBins.
+   \param first the index of the first frequency bin
+   \param bins the number of frequency bins
+   */
+  void selectBins(int first, int bins);
+
   /*!
    This method computes R. It is an implementation of \ref eq "Eq. 5". It is
    called only when the object is constructed.
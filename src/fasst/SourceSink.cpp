@@ -0,0 +1,51 @@
+#include "SourceSink.h"
+
+using namespace std;
+using namespace Eigen;
+
+namespace fasst {
+void SourceCollector::write(const vector<ArrayXXd> &y) {
+  for (size_t j = 0; j < y.size(); j++) {
+    if (m_position == 0) {
+      m_output[j] = Audio(ArrayXXd(m_samples, y[j].cols()), m_samplerate);
+    }
+    m_output[j].block(m_position, 0, y[j].rows(), y[j].cols()) = y[j];
+  }
+  m_position += y[0].rows();
+}
+
+SourceWriter::~SourceWriter() {
+  for (size_t j = 0; j < m_writers.size(); j++) {
+    delete m_writers[j];
+  }
+}
+
+void SourceWriter::write(const vector<ArrayXXd> &y) {
+  // The files are opened with the first block, which gives the number of
+  // channels of each source
+  for (size_t j = m_writers.size(); j < y.size(); j++) {
+    m_writers.push_back(
+        new AudioWriter(m_fnames[j], y[j].cols(), m_samplerate, m_format));
+  }
+  for (size_t j = 0; j < y.size(); j++) {
+    m_writers[j]->write(y[j]);
+  }
+}
+
+void SourceMultiplexer::write(const vector<ArrayXXd> &y) {
+  int channels = 0;
+  for (size_t j = 0; j < y.size(); j++) {
+    channels += y[j].cols();
+  }
+  if (!m_writer) {
+    m_writer = new AudioWriter(m_fname, channels, m_samplerate, m_format);
+  }
+  m_block.resize(y[0].rows(), channels);
+  int first = 0;
+  for (size_t j = 0; j < y.size(); j++) {
+    m_block.middleCols(first, y[j].cols()) = y[j];
+    first += y[j].cols();
+  }
+  m_writer->write(m_block);
+}
+}
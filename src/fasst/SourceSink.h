@@ -0,0 +1,135 @@
+#ifndef FASST_SOURCESINK_H
+#define FASST_SOURCESINK_H
+
+#include "Audio.h"
+#include <vector>
+
+namespace fasst {
+
+/*!
+ This class is an abstract base class for the consumers of the source signals
+ which are estimated block by block. Blocks are delivered in chronological order
+ and each block contains the next samples of every source, so that a consumer
+ never has to hold the whole signals in memory.
+ */
+class SourceSink {
+public:
+  virtual ~SourceSink() {}
+
+  /*!
+   This pure virtual method is called each time a new block of the source
+   signals has been estimated.
+   \param y a \f$J\f$-vector of audio blocks, where each block is a
+   samples-by-channels array
+   */
+  virtual void write(const std::vector<Eigen::ArrayXXd> &y) = 0;
+};
+
+/*!
+ This class gathers the blocks of the source signals in memory so that they
+ can be used as whole audio signals once the estimation is done.
+ */
+class SourceCollector : public SourceSink {
+public:
+  /*!
+   \param sources the number of sources
+   \param samples the number of samples of each source signal
+   \param samplerate the samplerate of the source signals
+   */
+  SourceCollector(int sources, int samples, int samplerate)
+      : m_output(sources), m_samples(samples), m_samplerate(samplerate),
+        m_position(0) {}
+
+  /*!
+   This method copies a block of the source signals after the previous ones.
+   \param y a \f$J\f$-vector of audio blocks
+   */
+  void write(const std::vector<Eigen::ArrayXXd> &y);
+
+  /*!
+   \return the audio signal of each source
+   */
+  inline const std::vector<Audio> &output() const { return m_output; }
+
+private:
+  std::vector<Audio> m_output;
+  int m_samples;
+  int m_samplerate;
+  int m_position;
+};
+
+/*!
+ This class writes the blocks of each source signal to its own audio file as
+ soon as they are estimated. Each file is opened with the first block, which
+ gives the number of channels of the source: the number of channels of the
+ mixture with the STFT, the rank of the source with the ERB transform.
+ */
+class SourceWriter : public SourceSink {
+public:
+  /*!
+   \param fnames the name of the audio file of each source
+   \param samplerate the samplerate
+   \param format the sample format, see AudioWriter::AudioWriter
+   */
+  SourceWriter(const std::vector<std::string> &fnames, int samplerate,
+               const std::string &format)
+      : m_fnames(fnames), m_samplerate(samplerate), m_format(format) {}
+
+  ~SourceWriter();
+
+  /*!
+   This method writes a block of each source signal to its file.
+   \param y a \f$J\f$-vector of audio blocks
+   */
+  void write(const std::vector<Eigen::ArrayXXd> &y);
+
+private:
+  SourceWriter(const SourceWriter &);
+  SourceWriter &operator=(const SourceWriter &);
+
+  std::vector<std::string> m_fnames;
+  int m_samplerate;
+  std::string m_format;
+  std::vector<AudioWriter *> m_writers;
+};
+
+/*!
+ This class writes the blocks of all the source signals to a single audio
+ stream. Each sample of the stream holds the channels of the first source, then
+ the channels of the second source, and so on, so that the \f$J\f$ sources can
+ go through one pipe. As with SourceWriter, the stream is opened with the first
+ block, which gives the number of channels of each source.
+ */
+class SourceMultiplexer : public SourceSink {
+public:
+  /*!
+   \param fname the name of the audio file, or `-` for the standard output
+   \param samplerate the samplerate
+   \param format the sample format, see AudioWriter::AudioWriter
+   */
+  SourceMultiplexer(const std::string &fname, int samplerate,
+                    const std::string &format)
+      : m_fname(fname), m_samplerate(samplerate), m_format(format),
+        m_writer(0) {}
+
+  ~SourceMultiplexer() { delete m_writer; }
+
+  /*!
+   This method writes a block of all the source signals to the stream.
+   \param y a \f$J\f$-vector of audio blocks
+   */
+  void write(const std::vector<Eigen::ArrayXXd> &y);
+
+private:
+  SourceMultiplexer(const SourceMultiplexer &);
+  SourceMultiplexer &operator=(const SourceMultiplexer &);
+
+  std::string m_fname;
+  int m_samplerate;
+  std::string m_format;
+  AudioWriter *m_writer;
+  Eigen::ArrayXXd m_block;
+};
+}
+
+#endif
@@ -1,8 +1,10 @@
 #include "Sources.h"
+#include "Profiler.h"
 #include "TFRepr.h"
 #include "ERBRepr.h"
 #include "Audio.h"
 #include "NaturalStatistics.h"
+#include "SourceSink.h"
 #include <Eigen/Dense>
 #include <stdexcept>
 #include <iostream>
@@ -11,7 +13,7 @@ using namespace std;
 using namespace Eigen;
 
 namespace fasst {
-Sources::Sources(QDomNodeList nodeList) {
+Sources::Sources(QDomNodeList nodeList) : m_online(false) {
   // Load sources
   int R = 0;
   for (size_t j = 0; j < static_cast<size_t>(nodeList.length()); j++) {
@@ -60,9 +62,44 @@ Sources::Sources(QDomNodeList nodeList) {
   }
 }
 
+Sources::Sources(const Sources &sources, int first, int frames)
+    : m_A(sources.m_A), m_bins(sources.m_bins), m_frames(frames),
+      m_channels(sources.m_channels), m_online(false) {
+  for (size_t j = 0; j < sources.m_sources.size(); j++) {
+    m_sources.push_back(Source(sources.m_sources[j], first, frames));
+  }
+}
+
 void Sources::replace(QDomDocument doc, QDomNodeList nodeList) {
-  // Update each source mixing parameter with A
+  syncMixingParameter();
+
+  // Replace the old source parameters with the new ones
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].replace(doc, nodeList.item(j));
+  }
+}
+
+void Sources::syncMixingParameter() {
+  // Nothing is done when every source already has its block of A, so that the
+  // inverses and the smoothed spectral powers are kept
+  bool synced = true;
   int sum = 0;
+  for (size_t j = 0; j < m_sources.size() && synced; j++) {
+    int bins = m_sources[j].isInst() ? 1 : m_bins;
+    for (int f = 0; f < bins && synced; f++) {
+      synced = m_sources[j].A(f) ==
+               m_A(f).block(0, sum, m_channels, m_sources[j].rank());
+    }
+    sum += m_sources[j].rank();
+  }
+  if (synced) {
+    return;
+  }
+
+  m_Sigma_x_inverse.resize(0, 0);
+
+  // Update each source mixing parameter with A
+  sum = 0;
   for (size_t j = 0; j < m_sources.size(); j++) {
     if (m_sources[j].isInst()) {
       m_sources[j].A(0) = m_A(0).block(0, sum, m_channels, m_sources[j].rank());
@@ -73,17 +110,21 @@ void Sources::replace(QDomDocument doc, QDomNodeList nodeList) {
       }
     }
     sum += m_sources[j].rank();
+    m_sources[j].compR();
   }
+}
 
-  // Replace the old source parameters with the new ones
+bool Sources::isInst() const {
   for (size_t j = 0; j < m_sources.size(); j++) {
-    m_sources[j].replace(doc, nodeList.item(j));
+    if (!m_sources[j].isInst()) {
+      return false;
+    }
   }
+  return true;
 }
 
-void Sources::updateMixingParameter(const NaturalStatistics &stats) {
-  // Indices
-  vector<int> ind_C, ind_Ccomp, ind_I, ind_Icomp;
+void Sources::mixingIndices(vector<int> &ind_C, vector<int> &ind_Ccomp,
+                            vector<int> &ind_I, vector<int> &ind_Icomp) const {
   int current_index = 0;
   for (size_t j = 0; j < m_sources.size(); j++) {
     vector<int> ind_j(m_sources[j].rank());
@@ -105,8 +146,27 @@ void Sources::updateMixingParameter(const NaturalStatistics &stats) {
       ind_Ccomp.insert(ind_Ccomp.end(), ind_j.begin(), ind_j.end());
     }
   }
+}
+
+void Sources::updateMixingParameter(const NaturalStatistics &stats) {
+  updateConvolutiveMixing(stats);
+  MatrixXcd sum, sum_hat_Rs_I;
+  sumInstantaneousMixing(stats, sum, sum_hat_Rs_I);
+  solveInstantaneousMixing(sum, sum_hat_Rs_I);
+}
+
+void Sources::updateConvolutiveMixing(const NaturalStatistics &stats) {
+  m_Sigma_x_inverse.resize(0, 0);
+
+  // Indices
+  vector<int> ind_C, ind_Ccomp, ind_I, ind_Icomp;
+  mixingIndices(ind_C, ind_Ccomp, ind_I, ind_Icomp);
 
   // Eq. 26
+  if (m_online) {
+    m_stats.sum_C.resize(m_bins);
+    m_stats.sum_hat_Rs_C.resize(m_bins);
+  }
   for (int f = 0; f < m_bins; f++) {
     MatrixXcd A_Ccomp(m_channels, ind_Ccomp.size());
     for (size_t i = 0; i < ind_Ccomp.size(); i++) {
@@ -134,15 +194,31 @@ void Sources::updateMixingParameter(const NaturalStatistics &stats) {
         }
       }
     }
+    if (m_online) {
+      m_stats.sum_C(f) = sum;
+      m_stats.sum_hat_Rs_C(f) = sum_hat_Rs_C;
+      if (m_pastStats.sum_C.size() > 0) {
+        sum += m_pastStats.sum_C(f);
+        sum_hat_Rs_C += m_pastStats.sum_hat_Rs_C(f);
+      }
+    }
     MatrixXcd rhs = sum * sum_hat_Rs_C.inverse();
     for (size_t i = 0; i < ind_C.size(); i++) {
       m_A(f).col(ind_C[i]) = rhs.col(i);
     }
   }
+}
+
+void Sources::sumInstantaneousMixing(const NaturalStatistics &stats,
+                                     MatrixXcd &sum,
+                                     MatrixXcd &sum_hat_Rs_I) const {
+  // Indices
+  vector<int> ind_C, ind_Ccomp, ind_I, ind_Icomp;
+  mixingIndices(ind_C, ind_Ccomp, ind_I, ind_Icomp);
 
   // Eq. 27
-  MatrixXcd sum = MatrixXcd::Zero(m_channels, ind_I.size());
-  MatrixXcd sum_hat_Rs_I = MatrixXcd::Zero(ind_I.size(), ind_I.size());
+  sum = MatrixXcd::Zero(m_channels, ind_I.size());
+  sum_hat_Rs_I = MatrixXcd::Zero(ind_I.size(), ind_I.size());
   for (int f = 0; f < m_bins; f++) {
     MatrixXcd A_Icomp(m_channels, ind_Icomp.size());
     for (size_t i = 0; i < ind_Icomp.size(); i++) {
@@ -169,6 +245,24 @@ void Sources::updateMixingParameter(const NaturalStatistics &stats) {
       }
     }
   }
+}
+
+void Sources::solveInstantaneousMixing(MatrixXcd sum, MatrixXcd sum_hat_Rs_I) {
+  m_Sigma_x_inverse.resize(0, 0);
+
+  // Indices
+  vector<int> ind_C, ind_Ccomp, ind_I, ind_Icomp;
+  mixingIndices(ind_C, ind_Ccomp, ind_I, ind_Icomp);
+
+  // Eq. 27
+  if (m_online) {
+    m_stats.sum_I = sum;
+    m_stats.sum_hat_Rs_I = sum_hat_Rs_I;
+    if (m_pastStats.sum_I.size() > 0) {
+      sum += m_pastStats.sum_I;
+      sum_hat_Rs_I += m_pastStats.sum_hat_Rs_I;
+    }
+  }
   MatrixXd rhs = sum.real() * sum_hat_Rs_I.real().inverse();
   for (int f = 0; f < m_bins; f++) {
     for (size_t i = 0; i < ind_I.size(); i++) {
@@ -177,30 +271,170 @@ void Sources::updateMixingParameter(const NaturalStatistics &stats) {
   }
 }
 
-void Sources::updateSpectralPower(const NaturalStatistics &stats) {
+void Sources::setMixingParameter(int bin, const MatrixXcd &A) {
+  m_Sigma_x_inverse.resize(0, 0);
+  m_A(bin) = A;
+}
+
+vector<ArrayXXd> Sources::spectralStatistics(const NaturalStatistics &stats) const {
+  ScopedTimer timer("xi");
   int J = m_sources.size();
+  vector<ArrayXXd> Xi(J);
 
   int first = 0;
   for (int j = 0; j < J; j++) {
     // Compute Xi(f,n): Eq. 29
-    ArrayXXd Xi = ArrayXXd::Zero(m_bins, m_frames);
+    Xi[j] = ArrayXXd::Zero(m_bins, m_frames);
     int last = first + m_sources[j].rank();
     for (int r = first; r < last; r++) {
       for (int f = 0; f < m_bins; f++) {
         for (int n = 0; n < m_frames; n++) {
-          Xi(f, n) += stats.hatRs(f, n)(r, r).real();
+          Xi[j](f, n) += stats.hatRs(f, n)(r, r).real();
         }
       }
     }
-    Xi /= m_sources[j].rank();
+    Xi[j] /= m_sources[j].rank();
     first = last;
+  }
+  return Xi;
+}
 
-    // Update spectral parameters
-    m_sources[j].updateSpectralPower(Xi);
+void Sources::updateSpectralPower(const NaturalStatistics &stats) {
+  updateSpectralPower(spectralStatistics(stats));
+}
+
+void Sources::updateSpectralPower(const vector<ArrayXXd> &Xi) {
+  m_Sigma_x_inverse.resize(0, 0);
+
+  // Update spectral parameters
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].updateSpectralPower(Xi[j]);
   }
 }
 
-  vector<Audio> Sources::Filter(const Audio &x, std::string tfr_type, int wlen){
+void Sources::setSpectralPower(int j, const ArrayXXd &V) {
+  m_Sigma_x_inverse.resize(0, 0);
+  m_sources[j].setV(V);
+}
+
+Sources Sources::selectBins(int first, int bins) const {
+  Sources shard(*this);
+  shard.m_Sigma_x_inverse.resize(0, 0);
+  shard.m_A = m_A.segment(first, bins);
+  shard.m_bins = bins;
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    shard.m_sources[j].selectBins(first, bins);
+  }
+  return shard;
+}
+
+void Sources::startOnline() {
+  m_online = true;
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].startOnline();
+  }
+}
+
+void Sources::commit(double forgetting) {
+  if (!m_online) {
+    return;
+  }
+
+  // Mixing parameter
+  if (m_stats.sum_C.size() > 0) {
+    bool first = m_pastStats.sum_C.size() == 0;
+    if (first) {
+      m_pastStats.sum_C.resize(m_bins);
+      m_pastStats.sum_hat_Rs_C.resize(m_bins);
+    }
+    for (int f = 0; f < m_bins; f++) {
+      if (first) {
+        m_pastStats.sum_C(f) = forgetting * m_stats.sum_C(f);
+        m_pastStats.sum_hat_Rs_C(f) = forgetting * m_stats.sum_hat_Rs_C(f);
+      } else {
+        m_pastStats.sum_C(f) =
+            forgetting * (m_pastStats.sum_C(f) + m_stats.sum_C(f));
+        m_pastStats.sum_hat_Rs_C(f) = forgetting * (m_pastStats.sum_hat_Rs_C(f) +
+                                                    m_stats.sum_hat_Rs_C(f));
+      }
+    }
+    if (m_pastStats.sum_I.size() == 0) {
+      m_pastStats.sum_I = forgetting * m_stats.sum_I;
+      m_pastStats.sum_hat_Rs_I = forgetting * m_stats.sum_hat_Rs_I;
+    } else {
+      m_pastStats.sum_I = forgetting * (m_pastStats.sum_I + m_stats.sum_I);
+      m_pastStats.sum_hat_Rs_I =
+          forgetting * (m_pastStats.sum_hat_Rs_I + m_stats.sum_hat_Rs_I);
+    }
+    m_stats = MixingStatistics();
+  }
+
+  // Spectral parameters
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].commit(forgetting);
+  }
+}
+
+void Sources::resizeFrames(int frames) {
+  m_Sigma_x_inverse.resize(0, 0);
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].resizeFrames(frames);
+  }
+  m_frames = frames;
+}
+
+void Sources::replaceFrames(const Sources &block, int first) {
+  m_Sigma_x_inverse.resize(0, 0);
+  m_A = block.m_A;
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].replaceFrames(block.m_sources[j], first);
+  }
+}
+
+void Sources::compV() {
+  for (size_t j = 0; j < m_sources.size(); j++) {
+    m_sources[j].compV();
+  }
+}
+
+vector<Audio> Sources::Filter(const Audio &x, std::string tfr_type, int wlen) {
+  SourceCollector collector(size(), x.samples(), x.samplerate());
+  Filter(x, tfr_type, wlen, collector);
+  return collector.output();
+}
+
+void Sources::Filter(const Audio &x, std::string tfr_type, int wlen, SourceSink &sink) {
+  Filter(x, tfr_type, wlen, sink, 0);
+}
+
+void Sources::Filter(const Audio &x, std::string tfr_type, int wlen, SourceSink &sink, int blockFrames) {
+  // Switch TFR type
+  if (tfr_type == "STFT") {
+    vector<Audio> output = TFRepr::FilterSTFT(x, wlen, m_sources, SigmaXInverse());
+    sink.write(vector<ArrayXXd>(output.begin(), output.end()));
+  } else if (tfr_type == "ERB") {
+    ERBRepr::FilterERB(x, wlen, m_sources, SigmaXInverse(), sink, blockFrames);
+  } else {
+    stringstream s;
+    s << "Wrong TFR type" << tfr_type << ".";
+    throw runtime_error(s.str());
+  }
+}
+
+void Sources::Filter(const TFRepr &X, int wlen, int samples, SourceSink &sink) {
+  vector<Audio> output = TFRepr::FilterSTFT(X, wlen, samples, m_sources, SigmaXInverse());
+  sink.write(vector<ArrayXXd>(output.begin(), output.end()));
+}
+
+void Sources::prepareFilter() { SigmaXInverse(); }
+
+const ArrayMatrixXcd &Sources::SigmaXInverse() {
+  // The smoothing and the inverses only depend on the parameters, so they are
+  // kept until the parameters are updated
+  if (m_Sigma_x_inverse.size() > 0) {
+    return m_Sigma_x_inverse;
+  }
+
   int N = m_frames;
   int F = m_bins;
   int I = m_channels;
@@ -219,7 +453,8 @@ void Sources::updateSpectralPower(const NaturalStatistics &stats) {
   }
 
   // Compute Sigma_x inverse
-  ArrayMatrixXcd Sigma_x_inverse(F, N);
+  ArrayMatrixXcd &Sigma_x_inverse = m_Sigma_x_inverse;
+  Sigma_x_inverse.resize(F, N);
   for (int n = 0; n < N; n++) {
     for (int f = 0; f < F; f++) {
       MatrixXcd Sigma_x = MatrixXcd::Zero(I, I);
@@ -229,19 +464,7 @@ void Sources::updateSpectralPower(const NaturalStatistics &stats) {
       Sigma_x_inverse(f, n) = Sigma_x.inverse();
     }
   }
-
-  // Switch TFR type
-  vector<Audio> output(J);
-  if (tfr_type == "STFT") {
-    output = TFRepr::FilterSTFT(x, wlen, m_sources, Sigma_x_inverse);
-  } else if (tfr_type == "ERB") {
-    output = ERBRepr::FilterERB(x, wlen, m_sources, Sigma_x_inverse);
-  } else {
-    stringstream s;
-    s << "Wrong TFR type" << tfr_type << ".";
-    throw runtime_error(s.str());
-  }
-  return output;
+  return Sigma_x_inverse;
 }
 
 }
@@ -9,6 +9,7 @@ using namespace std;
 
 namespace fasst {
 class NaturalStatistics;
+class SourceSink;
 
 /*!
  This class represents a set of sources. In addition, it has an attribute for A
@@ -27,6 +28,16 @@ public:
    */
   Sources(QDomNodeList nodeList);
 
+  /*!
+   This constructor copies some sources on some consecutive time frames only,
+   so that they can be estimated on these frames, see Source::Source(const
+   Source &, int, int).
+   \param sources the sources to be copied
+   \param first the index of the first time frame
+   \param frames the number of time frames
+   */
+  Sources(const Sources &sources, int first, int frames);
+
   /*!
    This method updates each source individual mixing parameter with the global
    mixing parameter, and then replace the XML data with the updated sources.
@@ -35,6 +46,16 @@ public:
    */
   void replace(QDomDocument doc, QDomNodeList nodeList);
 
+  /*!
+   This method updates each source individual mixing parameter and spatial
+   covariance matrix with the global mixing parameter, and drops the inverses
+   kept for the Wiener filter. It must be called before filtering with sources
+   estimated in memory, as the GEM algorithm only updates A. Nothing is done
+   if the individual mixing parameters are already up to date, so that calling
+   it before each filtering doesn't smooth the spectral powers again.
+   */
+  void syncMixingParameter();
+
   /*!
    This method is an implementation of \ref eq "Eq. 26" and \ref eq "Eq. 27". It
    computes an
@@ -42,6 +63,41 @@ public:
    */
   void updateMixingParameter(const NaturalStatistics &stats);
 
+  /*!
+   This method is the part of updateMixingParameter which implements \ref eq
+   "Eq. 26": it updates the convolutive mixing parameters, each frequency bin
+   independently of the other ones.
+   \param stats the natural statistics
+   */
+  void updateConvolutiveMixing(const NaturalStatistics &stats);
+
+  /*!
+   This method computes the sums over the frequency bins and the time frames
+   of \ref eq "Eq. 27", so that the sums of several frequency shards can be
+   added before solveInstantaneousMixing is called. It is called after
+   updateConvolutiveMixing.
+   \param stats the natural statistics
+   \param sum the \f$I \times R_I\f$-matrix on the left of Eq. 27
+   \param sum_hat_Rs_I the \f$R_I \times R_I\f$-matrix on the right of Eq. 27
+   */
+  void sumInstantaneousMixing(const NaturalStatistics &stats,
+                              Eigen::MatrixXcd &sum,
+                              Eigen::MatrixXcd &sum_hat_Rs_I) const;
+
+  /*!
+   This method updates the instantaneous mixing parameters from the sums of
+   \ref eq "Eq. 27", see sumInstantaneousMixing.
+   */
+  void solveInstantaneousMixing(Eigen::MatrixXcd sum,
+                                Eigen::MatrixXcd sum_hat_Rs_I);
+
+  /*!
+   This method sets the global mixing parameter at a given frequency bin.
+   \param bin the frequency bin index
+   \param A the \f$I \times R\f$-matrix
+   */
+  void setMixingParameter(int bin, const Eigen::MatrixXcd &A);
+
   /*!
    This method does two things:
    1. It computes Xi with natural statistics, which corresponds to \ref eq "Eq.
@@ -50,12 +106,125 @@ public:
    */
   void updateSpectralPower(const NaturalStatistics &stats);
 
+  /*!
+   This method computes Xi with natural statistics, which corresponds to \ref
+   eq "Eq. 29".
+   \return the \f$F \times N\f$-array Xi of each source
+   */
+  std::vector<Eigen::ArrayXXd>
+  spectralStatistics(const NaturalStatistics &stats) const;
+
+  /*!
+   This method calls the Source::updateSpectralPower on each source.
+   \param Xi the \f$F \times N\f$-array Xi of each source, see
+   spectralStatistics
+   */
+  void updateSpectralPower(const std::vector<Eigen::ArrayXXd> &Xi);
+
+  /*!
+   This method sets the spectral power of a source, see Source::setV.
+   \param j the source index
+   \param V the \f$F \times N\f$-array of the spectral power
+   */
+  void setSpectralPower(int j, const Eigen::ArrayXXd &V);
+
+  /*!
+   This method copies the sources on some consecutive frequency bins only, so
+   that the E-step, updateConvolutiveMixing and sumInstantaneousMixing can be
+   computed on these bins. The spectral parameters are not restricted, so the
+   copy is not meant to be updated with updateSpectralPower.
+   \param first the index of the first frequency bin
+   \param bins the number of frequency bins
+   \return the sources on the frequency bins
+   */
+  Sources selectBins(int first, int bins) const;
+
+  /*!
+   This method enables the online EM algorithm, which estimates the parameters
+   block of frames by block of frames: the mixing parameters and the spectral
+   parameters which are shared by all the frames are then updated with the
+   statistics of the previous blocks too, while the activations are only
+   estimated on the current block.
+   */
+  void startOnline();
+
+  /*!
+   This method accumulates the statistics of the current block of frames, so
+   that they are used to estimate the next blocks. It is called once the
+   current block has been estimated.
+   \param forgetting the forgetting factor between 0 and 1, the statistics of
+   a block being weighted by its power for each following block
+   */
+  void commit(double forgetting);
+
+  /*!
+   This method changes the number of time frames of the sources, so that they
+   match the next block of frames with the online EM algorithm. Please note
+   that if the activations of a source are not defined, the method will throw a
+   `runtime_error` exception.
+   \param frames the number of time frames
+   */
+  void resizeFrames(int frames);
+
+  /*!
+   This method copies the mixing parameter and the spectral parameters shared
+   by all the time frames from some sources built by Sources(const Sources &,
+   int, int), and replaces their time frames of the activations. The spectral
+   powers are not recomputed until compV is called.
+   \param block the sources estimated on the time frames
+   \param first the index of the first time frame
+   */
+  void replaceFrames(const Sources &block, int first);
+
+  /*!
+   This method recomputes the spectral power of each source, see Source::compV.
+   */
+  void compV();
+
   /*!
    This method computes each source estimates and write output audio files .
    It is an implementation of \ref eq "Eq. 31" with additional parameters.
    */
   std::vector<Audio> Filter (const Audio &x, std::string tfr_type, int wlen);
 
+  /*!
+   This method computes each source estimates and gives them to a sink. With
+   the ERB transform, the estimates are computed and given block by block.
+   It is an implementation of \ref eq "Eq. 31" with additional parameters.
+   */
+  void Filter (const Audio &x, std::string tfr_type, int wlen, SourceSink &sink);
+
+  /*!
+   This method computes each source estimates and gives them to a sink, the
+   ERB estimates being computed by blocks of a given number of time frames.
+   \param x the mixture
+   \param tfr_type the time-frequency representation, `STFT` or `ERB`
+   \param wlen the window length
+   \param sink the consumer of the source estimates
+   \param blockFrames the number of time frames of each ERB block, or 0 to
+   choose it
+   */
+  void Filter (const Audio &x, std::string tfr_type, int wlen, SourceSink &sink, int blockFrames);
+
+  /*!
+   This method computes each source estimates from the already computed STFT
+   of the mixture and gives them to a sink. It is an implementation of \ref eq
+   "Eq. 31" with additional parameters.
+   \param X the STFT of the mixture
+   \param wlen the window length
+   \param samples the number of samples of the mixture
+   \param sink the consumer of the source estimates
+   */
+  void Filter (const TFRepr &X, int wlen, int samples, SourceSink &sink);
+
+  /*!
+   This method smoothes the spectral powers if needed and computes the inverse
+   of the model covariance matrices, which only depend on the parameters. It is
+   otherwise done by the first call to Filter, and kept until the parameters
+   are updated.
+   */
+  void prepareFilter();
+
   /*!
    This overloaded []-operator gives acces to an individual source.
    \param i the source index
@@ -71,6 +240,12 @@ public:
    */
   inline const Eigen::MatrixXcd &A(int bin) const { return m_A(bin); }
 
+  /*!
+   \return true if every source has an instantaneous mixing parameter, _ie._
+   if A is the same for all the frequency bins
+   */
+  bool isInst() const;
+
   /*!
    \return the number of sources
    */
@@ -92,9 +267,36 @@ public:
   inline int channels() const { return m_channels; }
 
 private:
+  /*!
+   This method splits the indices of the columns of the global mixing
+   parameter between the free convolutive ones (C), the free instantaneous ones
+   (I) and their complements.
+   */
+  void mixingIndices(std::vector<int> &ind_C, std::vector<int> &ind_Ccomp,
+                     std::vector<int> &ind_I,
+                     std::vector<int> &ind_Icomp) const;
+
+  /*!
+   This method smoothes the spectral powers if needed, updates Sigma_y of each
+   source and computes the inverse of the model covariance matrices, unless it
+   has already been done since the last update of the parameters.
+   \return the \f$F \times N\f$-array of inverse \f$I \times I\f$-matrices
+   */
+  const ArrayMatrixXcd &SigmaXInverse();
+
+  // Sums over the frames in the update of the mixing parameter (Eq. 26 and
+  // Eq. 27), which are kept by the online EM algorithm
+  struct MixingStatistics {
+    VectorMatrixXcd sum_C, sum_hat_Rs_C;
+    Eigen::MatrixXcd sum_I, sum_hat_Rs_I;
+  };
+
   std::vector<Source> m_sources;
   VectorMatrixXcd m_A;
+  ArrayMatrixXcd m_Sigma_x_inverse;
   int m_bins, m_frames, m_channels;
+  bool m_online;
+  MixingStatistics m_stats, m_pastStats;
 };
 }
 
@@ -0,0 +1,96 @@
+#include "Sources.h"
+#include "NaturalStatistics.h"
+#include "ERBRepr.h"
+#include "bench.h"
+#include <benchmark/benchmark.h>
+
+using namespace fasst;
+
+// Ten seconds of audio at 16 kHz
+static const int SAMPLES = 160000;
+
+// Sweeps the number of channels, the number of sources of rank 1, the number
+// of bins and the number of frames
+static void channelsRanksBinsAndFrames(benchmark::internal::Benchmark *b) {
+  for (int I = 2; I <= 8; I *= 2) {
+    for (int R = 2; R <= 8; R *= 2) {
+      for (int F = 257; F <= 1025; F = F * 2 - 1) {
+        b->Args({I, R, F, 250});
+      }
+    }
+  }
+}
+
+static void updateMixingParameter(benchmark::State &state, bool conv) {
+  int I = state.range(0);
+  int R = state.range(1);
+  int F = state.range(2);
+  int N = state.range(3);
+  Sources sources = benchSources(I, R, 8, F, N, conv);
+  MixCovMatrix hatRx(benchTFRepr(I, F, N));
+  VectorMatrixXcd Sigma_b(F);
+  for (int f = 0; f < F; f++) {
+    Sigma_b(f) = Eigen::MatrixXcd::Identity(I, I) * 1e-2;
+  }
+  NaturalStatistics stats(sources, hatRx, Sigma_b);
+  while (state.KeepRunning()) {
+    sources.updateMixingParameter(stats);
+  }
+  state.SetItemsProcessed(state.iterations() * F * N);
+}
+
+static void Sources_updateInstantaneousMixing(benchmark::State &state) {
+  updateMixingParameter(state, false);
+}
+BENCHMARK(Sources_updateInstantaneousMixing)
+    ->Apply(channelsRanksBinsAndFrames);
+
+static void Sources_updateConvolutiveMixing(benchmark::State &state) {
+  updateMixingParameter(state, true);
+}
+BENCHMARK(Sources_updateConvolutiveMixing)->Apply(channelsRanksBinsAndFrames);
+
+// Sweeps the number of channels, the number of sources and the window length
+static void channelsSourcesAndWindows(benchmark::internal::Benchmark *b) {
+  for (int I = 1; I <= 4; I *= 2) {
+    for (int J = 2; J <= 4; J *= 2) {
+      for (int wlen = 512; wlen <= 2048; wlen *= 2) {
+        b->Args({I, J, wlen});
+      }
+    }
+  }
+}
+
+// The Wiener filter is applied with model covariance matrices which are
+// already inverted, as when the same sources filter several mixtures
+static void Sources_filterSTFT(benchmark::State &state) {
+  int I = state.range(0);
+  int J = state.range(1);
+  int wlen = state.range(2);
+  Audio x = benchAudio(SAMPLES, I);
+  TFRepr X(x, wlen);
+  Sources sources = benchSources(I, J, 8, X.bins(), X.frames(), false);
+  sources.prepareFilter();
+  while (state.KeepRunning()) {
+    std::vector<Audio> y = sources.Filter(x, "STFT", wlen);
+    benchmark::DoNotOptimize(y[0].data());
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLES);
+}
+BENCHMARK(Sources_filterSTFT)->Apply(channelsSourcesAndWindows);
+
+static void Sources_filterERB(benchmark::State &state) {
+  int I = state.range(0);
+  int J = state.range(1);
+  int wlen = state.range(2);
+  Audio x = benchAudio(SAMPLES, I);
+  ERBRepr X(x, wlen, 64);
+  Sources sources = benchSources(I, J, 8, X.rows(), X.cols(), false);
+  sources.prepareFilter();
+  while (state.KeepRunning()) {
+    std::vector<Audio> y = sources.Filter(x, "ERB", wlen);
+    benchmark::DoNotOptimize(y[0].data());
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLES);
+}
+BENCHMARK(Sources_filterERB)->Apply(channelsSourcesAndWindows);
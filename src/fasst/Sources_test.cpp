@@ -1,4 +1,8 @@
 #include "Sources.h"
+#include "GEM.h"
+#include "MixCovMatrix.h"
+#include "SourceSink.h"
+#include "bench.h"
 #include <stdexcept>
 #include "gtest/gtest.h"
 
@@ -197,3 +201,200 @@ TEST(Sources, WrongNumberOfFrames) {
   QDomNodeList list = doc.elementsByTagName("source");
   ASSERT_THROW(Sources src(list), runtime_error);
 }
+
+TEST(Sources, ResizeFrames) {
+  QString str = "<sources>"
+                "<source>"
+                "<A adaptability=\"free\" mixing_type=\"inst\">"
+                "<ndims>2</ndims>"
+                "<dim>1</dim>"
+                "<dim>1</dim>"
+                "<type>real</type>"
+                "<data>1 </data>"
+                "</A>"
+                "<Wex adaptability=\"free\">"
+                "<rows>1</rows>"
+                "<cols>1</cols>"
+                "<data>1 </data>"
+                "</Wex>"
+                "<Uex adaptability=\"fixed\">"
+                "<rows>1</rows>"
+                "<cols>1</cols>"
+                "<data>1 </data>"
+                "</Uex>"
+                "<Gex adaptability=\"free\">"
+                "<rows>1</rows>"
+                "<cols>1</cols>"
+                "<data>1 </data>"
+                "</Gex>"
+                "<Hex adaptability=\"free\">"
+                "<rows>1</rows>"
+                "<cols>3</cols>"
+                "<data>1\n2\n3 </data>"
+                "</Hex>"
+                "</source>"
+                "</sources>";
+
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(str));
+  QDomNodeList list = doc.elementsByTagName("source");
+  Sources src(list);
+  ASSERT_EQ(src.frames(), 3);
+
+  // The first frames are kept
+  src.resizeFrames(2);
+  ASSERT_EQ(src.frames(), 2);
+  ASSERT_EQ(src[0].frames(), 2);
+  ASSERT_EQ(src[0].V(0, 1), 2.);
+
+  // The new frames are copies of the last one
+  src.resizeFrames(4);
+  ASSERT_EQ(src.frames(), 4);
+  ASSERT_EQ(src[0].V(0, 3), 2.);
+}
+
+TEST(Sources, SelectFrames) {
+  QString str = "<sources>"
+                "<source>"
+                "<A adaptability=\"free\" mixing_type=\"inst\">"
+                "<ndims>2</ndims>"
+                "<dim>1</dim>"
+                "<dim>1</dim>"
+                "<type>real</type>"
+                "<data>1 </data>"
+                "</A>"
+                "<Wex adaptability=\"free\">"
+                "<rows>1</rows>"
+                "<cols>1</cols>"
+                "<data>1 </data>"
+                "</Wex>"
+                "<Uex adaptability=\"fixed\">"
+                "<rows>1</rows>"
+                "<cols>1</cols>"
+                "<data>1 </data>"
+                "</Uex>"
+                "<Gex adaptability=\"free\">"
+                "<rows>1</rows>"
+                "<cols>1</cols>"
+                "<data>1 </data>"
+                "</Gex>"
+                "<Hex adaptability=\"free\">"
+                "<rows>1</rows>"
+                "<cols>4</cols>"
+                "<data>1\n2\n3\n4 </data>"
+                "</Hex>"
+                "</source>"
+                "</sources>";
+
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(str));
+  QDomNodeList list = doc.elementsByTagName("source");
+  Sources src(list);
+  ASSERT_EQ(src.frames(), 4);
+
+  // The block only holds the selected frames
+  Sources block(src, 1, 2);
+  ASSERT_EQ(block.frames(), 2);
+  ASSERT_EQ(block[0].V(0, 0), 2.);
+  ASSERT_EQ(block[0].V(0, 1), 3.);
+
+  // The frames of the block replace the selected frames only
+  block.resizeFrames(1);
+  block.resizeFrames(2);
+  src.replaceFrames(block, 1);
+  src.compV();
+  ASSERT_EQ(src[0].V(0, 0), 1.);
+  ASSERT_EQ(src[0].V(0, 1), 2.);
+  ASSERT_EQ(src[0].V(0, 2), 2.);
+  ASSERT_EQ(src[0].V(0, 3), 4.);
+}
+
+TEST(Sources, FilterAfterEstimation) {
+  // The sources are estimated and then filtered in memory, as fasst-separate
+  // does, and from the XML document written after the estimation, as
+  // model-estimation and source-estimation do
+  Audio x = benchAudio(4096, 2);
+  int wlen = 256;
+  TFRepr X(x, wlen);
+  MixCovMatrix hatRx(X);
+  string str = "<sources>";
+  for (int j = 0; j < 2; j++) {
+    str += benchSource(2, 3, X.bins(), X.frames(), true, j);
+  }
+  str += "</sources>";
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(QString::fromStdString(str)));
+  Sources sources(doc.elementsByTagName("source"));
+
+  GEM gem(sources, hatRx, 3);
+  for (int iter = 0; iter < 3; iter++) {
+    gem.next();
+  }
+  sources.syncMixingParameter();
+  SourceCollector inMemory(2, x.samples(), x.samplerate());
+  sources.Filter(X, wlen, x.samples(), inMemory);
+
+  sources.replace(doc, doc.elementsByTagName("source"));
+  Sources reloaded(doc.elementsByTagName("source"));
+  SourceCollector fromFile(2, x.samples(), x.samplerate());
+  reloaded.Filter(X, wlen, x.samples(), fromFile);
+
+  // The XML document keeps 6 significant digits
+  for (int j = 0; j < 2; j++) {
+    const Eigen::ArrayXXd &y = inMemory.output()[j];
+    const Eigen::ArrayXXd &y_ref = fromFile.output()[j];
+    ASSERT_EQ(y.rows(), y_ref.rows());
+    ASSERT_EQ(y.cols(), y_ref.cols());
+    EXPECT_LT((y - y_ref).abs().maxCoeff(), 1e-3 * y_ref.abs().maxCoeff());
+  }
+}
+
+TEST(Sources, FilterERBBlocks) {
+  // The ERB estimates computed by small blocks of frames, which need the
+  // context on both sides, are those computed in a single block
+  Audio x = benchAudio(4096, 2);
+  int wlen = 64;
+  MixCovMatrix hatRx(x, "ERB", wlen, 16);
+  Sources sources =
+      benchSources(2, 2, 3, hatRx.bins(), hatRx.frames(), false);
+  SourceCollector blocks(2, x.samples(), x.samplerate());
+  sources.Filter(x, "ERB", wlen, blocks, 5);
+  SourceCollector single(2, x.samples(), x.samplerate());
+  sources.Filter(x, "ERB", wlen, single, hatRx.frames());
+
+  for (int j = 0; j < 2; j++) {
+    const Audio &y = blocks.output()[j];
+    const Audio &y_ref = single.output()[j];
+    ASSERT_EQ(x.samples(), y.samples());
+    ASSERT_EQ(y_ref.cols(), y.cols());
+    EXPECT_EQ(x.samplerate(), y.samplerate());
+    EXPECT_LT((y - y_ref).abs().maxCoeff(), 1e-9 * y_ref.abs().maxCoeff());
+  }
+}
+
+TEST(Sources, FilterTwice) {
+  // With temporal and frequency smoothing of the spectral powers, filtering
+  // twice with the same parameters gives the same estimates
+  Audio x = benchAudio(4096, 2);
+  int wlen = 256;
+  TFRepr X(x, wlen);
+  string str = "<sources>";
+  for (int j = 0; j < 2; j++) {
+    string source = benchSource(2, 3, X.bins(), X.frames(), false, j);
+    str += source.insert(string("<source>").size(),
+                         "<wiener><c1>2</c1><c2>2</c2></wiener>");
+  }
+  str += "</sources>";
+  QDomDocument doc;
+  ASSERT_TRUE(doc.setContent(QString::fromStdString(str)));
+  Sources sources(doc.elementsByTagName("source"));
+
+  vector<Audio> y[2];
+  for (int k = 0; k < 2; k++) {
+    sources.syncMixingParameter();
+    y[k] = sources.Filter(x, "STFT", wlen);
+  }
+  for (int j = 0; j < 2; j++) {
+    EXPECT_EQ(0., (y[0][j] - y[1][j]).abs().maxCoeff());
+  }
+}
@@ -1,4 +1,6 @@
 #include "SpectralPower.h"
+#include "Profiler.h"
+#include <stdexcept>
 using namespace std;
 using namespace Eigen;
 
@@ -7,7 +9,20 @@ SpectralPower::SpectralPower(QDomNode node, string suffix)
     : m_W(node.firstChildElement(QString::fromStdString("W" + suffix))),
       m_U(node.firstChildElement(QString::fromStdString("U" + suffix))),
       m_G(node.firstChildElement(QString::fromStdString("G" + suffix))),
-      m_H(node.firstChildElement(QString::fromStdString("H" + suffix))) {}
+      m_H(node.firstChildElement(QString::fromStdString("H" + suffix))),
+      m_UG(MatrixXd()), m_WU(MatrixXd()), m_WUG(MatrixXd()),
+      m_validV(false) {
+  compFixedProducts();
+}
+
+void SpectralPower::compFixedProducts() {
+  m_fixedUG = !m_U.isFree() && !m_G.isFree();
+  m_fixedWU = !m_W.isFree() && !m_U.isFree();
+  m_fixedWUG = m_fixedWU && !m_G.isFree();
+  m_UG = m_fixedUG ? m_U * m_G : NonNegMatrix(MatrixXd());
+  m_WU = m_fixedWU ? m_W * m_U : NonNegMatrix(MatrixXd());
+  m_WUG = m_fixedWUG ? m_WU * m_G : NonNegMatrix(MatrixXd());
+}
 
 void SpectralPower::replace(QDomDocument doc, QDomNode node,
                             string suffix) const {
@@ -30,47 +45,111 @@ void SpectralPower::replace(QDomDocument doc, QDomNode node,
 }
 
 void SpectralPower::update(const ArrayXXd &Xi) {
+  m_validV = false;
   if (m_W.isFree()) {
-    NonNegMatrix UGH = m_U * m_G * m_H;
+    ScopedTimer timer("W");
+    NonNegMatrix UGH = productUG() * m_H;
     m_W.update(Xi, UGH);
   }
 
   if (m_U.isFree()) {
+    ScopedTimer timer("U");
     NonNegMatrix GH = m_G * m_H;
     m_U.update(Xi, m_W, GH);
   }
 
   if (m_G.isFree()) {
-    NonNegMatrix WU = m_W * m_U;
+    ScopedTimer timer("G");
+    NonNegMatrix WU = productWU();
     m_G.update(Xi, WU, m_H);
   }
 
   if (m_H.isFree()) {
-    NonNegMatrix WUG = m_W * m_U * m_G;
+    ScopedTimer timer("H");
+    NonNegMatrix WUG = productWUG();
     m_H.update(Xi, WUG);
+
+    // H is updated last, so V is the product with the new H
+    m_V = WUG * m_H;
+    m_validV = true;
   }
 }
 
 void SpectralPower::update(const ArrayXXd &Xi, const ArrayXXd &E) {
+  m_validV = false;
   if (m_W.isFree()) {
-    NonNegMatrix UGH = m_U * m_G * m_H;
+    ScopedTimer timer("W");
+    NonNegMatrix UGH = productUG() * m_H;
     m_W.update(Xi, UGH, E);
   }
 
   if (m_U.isFree()) {
+    ScopedTimer timer("U");
     NonNegMatrix GH = m_G * m_H;
     m_U.update(Xi, m_W, GH, E);
   }
 
   if (m_G.isFree()) {
-    NonNegMatrix WU = m_W * m_U;
+    ScopedTimer timer("G");
+    NonNegMatrix WU = productWU();
     m_G.update(Xi, WU, m_H, E);
   }
 
   if (m_H.isFree()) {
-    NonNegMatrix WUG = m_W * m_U * m_G;
+    ScopedTimer timer("H");
+    NonNegMatrix WUG = productWUG();
     m_H.update(Xi, WUG, E);
+
+    // H is updated last, so V is the product with the new H
+    m_V = WUG * m_H;
+    m_validV = true;
+  }
+}
+
+void SpectralPower::startOnline() {
+  if (m_W.isFree() && !m_W.isEye()) {
+    m_W.startOnline();
+  }
+  if (m_U.isFree() && !m_U.isEye()) {
+    m_U.startOnline();
+  }
+  if (m_G.isFree() && !m_G.isEye()) {
+    m_G.startOnline();
   }
+}
+
+void SpectralPower::commit(double forgetting) {
+  m_W.commit(forgetting);
+  m_U.commit(forgetting);
+  m_G.commit(forgetting);
+}
+
+void SpectralPower::resizeFrames(int frames) {
+  if (m_H.isEye()) {
+    throw runtime_error("Check your source parameters: H must be defined to "
+                        "change the number of frames");
+  }
+  m_H.resizeFrames(frames);
+  m_validV = false;
+}
+
+void SpectralPower::selectFrames(int first, int frames) {
+  if (m_H.isEye()) {
+    throw runtime_error("Check your source parameters: H must be defined to "
+                        "select frames");
+  }
+  m_H.selectFrames(first, frames);
+  m_validV = false;
+}
 
+void SpectralPower::replaceFrames(const SpectralPower &block, int first) {
+  m_W = block.m_W;
+  m_U = block.m_U;
+  m_G = block.m_G;
+  m_H.replaceFrames(block.m_H, first);
+  m_UG = block.m_UG;
+  m_WU = block.m_WU;
+  m_WUG = block.m_WUG;
+  m_validV = false;
 }
 }
@@ -9,6 +9,10 @@ namespace fasst {
  This class represents either the excitation spectral power or the filter
  spectral power of a source. It has 4 NonNegMatrix objects to store W, U, G and
  H.
+
+ The products of the factors which are fixed, such as a fixed dictionary W and
+ fixed U and G, never change and are computed once. The spectral power itself
+ is kept until a factor changes.
     */
 class SpectralPower {
 public:
@@ -44,17 +48,95 @@ public:
   void update(const Eigen::ArrayXXd &Xi, const Eigen::ArrayXXd &E);
 
   /*!
-   This method is an implementation of \ref eq "Eq. 12".
+   This method is an implementation of \ref eq "Eq. 12". The product is only
+   computed again if a factor has changed since the previous call.
    \return the product of the four NonNegMatrix
    */
-  inline Eigen::ArrayXXd V() const {
-    return m_W * m_U * m_G * m_H;
+  inline const Eigen::ArrayXXd &V() const {
+    if (!m_validV) {
+      m_V = productWUG() * m_H;
+      m_validV = true;
+    }
+    return m_V;
   }
 
+  /*!
+   This method enables the online EM algorithm on W, U and G, which are shared
+   by all the blocks of frames, see NonNegMatrix::startOnline.
+   */
+  void startOnline();
+
+  /*!
+   This method accumulates the statistics of the current block of frames, see
+   NonNegMatrix::commit.
+   \param forgetting the forgetting factor, between 0 and 1
+   */
+  void commit(double forgetting);
+
+  /*!
+   This method changes the number of time frames of H, see H::resizeFrames.
+   Please note that if H is not defined, the method will throw a
+   `runtime_error` exception.
+   \param frames the number of time frames
+   */
+  void resizeFrames(int frames);
+
+  /*!
+   This method only keeps some consecutive time frames of H, see
+   H::selectFrames. Please note that if H is not defined, the method will
+   throw a `runtime_error` exception.
+   \param first the index of the first time frame to be kept
+   \param frames the number of time frames to be kept
+   */
+  void selectFrames(int first, int frames);
+
+  /*!
+   This method copies W, U and G from a spectral power which has been selected
+   from this one by selectFrames, and replaces the time frames of H with its
+   ones.
+   \param block the spectral power of the time frames
+   \param first the index of the first time frame
+   */
+  void replaceFrames(const SpectralPower &block, int first);
+
 private:
+  /*!
+   This method computes the products of the fixed factors.
+   */
+  void compFixedProducts();
+
+  /*!
+   \return the product of U and G
+   */
+  inline NonNegMatrix productUG() const {
+    return m_fixedUG ? m_UG : m_U * m_G;
+  }
+
+  /*!
+   \return the product of W and U
+   */
+  inline NonNegMatrix productWU() const {
+    return m_fixedWU ? m_WU : m_W * m_U;
+  }
+
+  /*!
+   \return the product of W, U and G
+   */
+  inline NonNegMatrix productWUG() const {
+    return m_fixedWUG ? m_WUG : productWU() * m_G;
+  }
+
   W m_W;
   UG m_U, m_G;
   H m_H;
+
+  // Products of fixed factors, valid when the flags are set
+  bool m_fixedUG, m_fixedWU, m_fixedWUG;
+  NonNegMatrix m_UG, m_WU, m_WUG;
+
+  // Spectral power, valid when the flag is set
+  mutable bool m_validV;
+  mutable Eigen::ArrayXXd m_V;
 };
 }
 
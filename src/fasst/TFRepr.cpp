@@ -1,5 +1,7 @@
 #include "TFRepr.h"
 #include "Audio.h"
+#include "Framing.h"
+#include "FFTPlans.h"
 #include "Sources.h"
 #include <stdexcept>
 #include <unsupported/Eigen/FFT>
@@ -19,31 +21,24 @@ TFRepr::TFRepr(const Audio &x, int wlen) {
     throw runtime_error(s.str());
   }
   
-  // Defining sine window
-  ArrayXd win =
-      Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
+  // Sine window and normalisation for edges
+  const Framing &framing = Framing::get(wlen);
+  double scale = 1. / std::sqrt(static_cast<double>(wlen));
 
   // Zero-padding
   int N = static_cast<int>(ceil(static_cast<double>(samples) / wlen * 2));
   ArrayXXd xx = ArrayXXd::Zero((N + 1) * wlen / 2, I);
   xx.block(wlen / 4, 0, samples, I) = x;
 
-  // Pre-processing for edges
-  ArrayXd swin = ArrayXd::Zero((N + 1) * wlen / 2);
-  for (int n = 0; n < N; n++) {
-    swin.segment(n * wlen / 2, wlen) += (win * win);
-  }
-  swin = Eigen::sqrt(wlen * swin);
-
   int F = wlen / 2 + 1;
   VectorMatrixXcd X(I);
-  FFT<double> fft;
+  FFT<double> &fft = FFTPlans::get();
   for (int i = 0; i < I; i++) {
     X(i) = ArrayXXcd(F, N);
     for (int n = 0; n < N; n++) {
       // Framing
-      VectorXd frame = xx.col(i).segment(n * wlen / 2, wlen) * win /
-                       swin.segment(n * wlen / 2, wlen);
+      VectorXd frame = xx.col(i).segment(n * wlen / 2, wlen) *
+                       framing.weights(n, N) * scale;
       // FFT
       VectorXcd fframe;
       fft.fwd(fframe, frame);
@@ -63,6 +58,64 @@ TFRepr::TFRepr(const Audio &x, int wlen) {
   }
 }
 
+TFRepr::TFRepr(AudioReader &reader, int wlen) {
+  int samples = reader.samples();
+  int I = reader.channels();
+  int hop = wlen / 2;
+
+  // Checking window length
+  if (wlen % 4 != 0 || wlen == 0) {
+    stringstream s;
+    s << "Error:\twlen is " << wlen << " and should be multiple of 4.\n";
+    throw runtime_error(s.str());
+  }
+
+  // The number of frames depends on the length of the audio signal
+  if (samples < 0) {
+    throw runtime_error("Error:\tthe length of the audio stream is unknown.\n");
+  }
+
+  // Sine window and normalisation for edges
+  const Framing &framing = Framing::get(wlen);
+  double scale = 1. / std::sqrt(static_cast<double>(wlen));
+
+  // Sliding frame over the zero-padded signal, which is read one hop at a
+  // time so that each frame is transformed as soon as its samples are known
+  int N = static_cast<int>(std::ceil(static_cast<double>(samples) / wlen * 2));
+  ArrayXXd xx = ArrayXXd::Zero(wlen, I);
+  ArrayXXd block(3 * wlen / 4, I);
+  reader.read(block);
+  xx.bottomRows(3 * wlen / 4) = block;
+  block.resize(hop, I);
+
+  int F = wlen / 2 + 1;
+  resize(F, N);
+  FFT<double> &fft = FFTPlans::get();
+  VectorXd frame(wlen);
+  VectorXcd fframe;
+  for (int n = 0; n < N; n++) {
+    for (int f = 0; f < F; f++) {
+      (*this)(f, n) = VectorXcd(I);
+    }
+    for (int i = 0; i < I; i++) {
+      // Framing
+      frame = xx.col(i) * framing.weights(n, N) * scale;
+      // FFT
+      fft.fwd(fframe, frame);
+      for (int f = 0; f < F; f++) {
+        (*this)(f, n)(i) = fframe(f);
+      }
+    }
+
+    // Next hop
+    if (n + 1 < N) {
+      xx.topRows(hop) = xx.bottomRows(hop);
+      reader.read(block);
+      xx.bottomRows(hop) = block;
+    }
+  }
+}
+
 std::vector<Audio> TFRepr::FilterSTFT(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse) {
 
   // Checking window length
@@ -74,10 +127,13 @@ std::vector<Audio> TFRepr::FilterSTFT(const Audio &x, int wlen, const std::vecto
   
   // Computing TF representation
   fasst::TFRepr X(x, wlen);
+  return FilterSTFT(X, wlen, x.samples(), srcs, Sigma_x_inverse);
+}
+
+std::vector<Audio> TFRepr::FilterSTFT(const TFRepr &X, int wlen, int samples, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse) {
   int F = X.bins();
   int N = X.frames();
   int J = srcs.size();
-  int samples = x.samples();
 
   // Checking if dimensions are consistent
   if (F != srcs[0].bins()) {
@@ -117,15 +173,9 @@ Audio TFRepr::inverse(int wlen, int samples) {
   int F = bins();
   int N = frames();
 
-  // Defining sine window
-  ArrayXd win = Eigen::sin(ArrayXd::LinSpaced(wlen, 0.5, wlen - 0.5) / wlen * M_PI);
-
-  // Pre-processing for edges
-  ArrayXd swin = ArrayXd::Zero((N + 1) * wlen / 2);
-  for (int n = 0; n < N; n++) {
-    swin.segment(n * wlen / 2, wlen) += (win * win);
-  }
-  swin = Eigen::sqrt(swin / wlen);
+  // Sine window and normalisation for edges
+  const Framing &framing = Framing::get(wlen);
+  double scale = std::sqrt(static_cast<double>(wlen));
 
   // See data as a I-vector of F-by-N-arrays
   VectorMatrixXcd X(I);
@@ -139,7 +189,7 @@ Audio TFRepr::inverse(int wlen, int samples) {
   }
 
   ArrayXXd x = ArrayXXd::Zero((N + 1) * wlen / 2, I);
-  FFT<double> fft;
+  FFT<double> &fft = FFTPlans::get();
   for (int i = 0; i < I; i++) {
     for (int n = 0; n < N; n++) {
       // IFFT
@@ -151,7 +201,7 @@ Audio TFRepr::inverse(int wlen, int samples) {
 
       // Overlap-add
       x.col(i).segment(n * wlen / 2, wlen) +=
-          frame.array() * win / swin.segment(n * wlen / 2, wlen);
+          frame.array() * framing.weights(n, N) * scale;
     }
   }
 
@@ -5,6 +5,7 @@
 
 namespace fasst {
 class Audio;
+class AudioReader;
 class Source;
 
 /*!
@@ -27,6 +28,17 @@ public:
    */
   TFRepr(const Audio &x, int wlen);
 
+  /*!
+   This constructor computes the STFT transform of an audio signal while it is
+   being read, so that the audio signal never has to be held in memory. The
+   length of the audio signal must be known, otherwise this constructor will
+   throw a `runtime_error` exception.
+   \param reader an audio reader
+   \param wlen the window length _ie._ the length (in audio samples) of one time
+   frame
+   */
+  TFRepr(AudioReader &reader, int wlen);
+
   /*!
    This constructor is used to initialize the storage of the data.
    \param bins the number of frequency bins
@@ -52,6 +64,18 @@ public:
    */
   static std::vector<Audio> FilterSTFT(const Audio &x, int wlen, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse);
 
+  /*!
+   This method applies the Wiener filter to the already computed STFT of the
+   mixture, then computes the inverse STFT.
+   \param X the STFT of the mixture audio signal
+   \param wlen the window length
+   \param samples the number of samples of the mixture audio signal
+   \param srcs the sources structure
+   \param Sigma_x_inverse the inverse of the model covariance matrix
+   \return the audio signal of each source
+   */
+  static std::vector<Audio> FilterSTFT(const TFRepr &X, int wlen, int samples, const std::vector<Source> &srcs, const ArrayMatrixXcd &Sigma_x_inverse);
+
   /*!
    \return the number of frequency bins
    */
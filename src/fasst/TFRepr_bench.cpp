@@ -0,0 +1,40 @@
+#include "TFRepr.h"
+#include "bench.h"
+#include <benchmark/benchmark.h>
+
+using namespace fasst;
+
+// Ten seconds of audio at 16 kHz
+static const int SAMPLES = 160000;
+
+// Sweeps the number of channels and the window length
+static void channelsAndWindows(benchmark::internal::Benchmark *b) {
+  for (int I = 1; I <= 4; I *= 2) {
+    for (int wlen = 512; wlen <= 2048; wlen *= 2) {
+      b->Args({I, wlen});
+    }
+  }
+}
+
+static void TFRepr_forward(benchmark::State &state) {
+  Audio x = benchAudio(SAMPLES, state.range(0));
+  int wlen = state.range(1);
+  while (state.KeepRunning()) {
+    TFRepr X(x, wlen);
+    benchmark::DoNotOptimize(X.data());
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLES);
+}
+BENCHMARK(TFRepr_forward)->Apply(channelsAndWindows);
+
+static void TFRepr_inverse(benchmark::State &state) {
+  Audio x = benchAudio(SAMPLES, state.range(0));
+  int wlen = state.range(1);
+  TFRepr X(x, wlen);
+  while (state.KeepRunning()) {
+    Audio y = X.inverse(wlen, SAMPLES);
+    benchmark::DoNotOptimize(y.data());
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLES);
+}
+BENCHMARK(TFRepr_inverse)->Apply(channelsAndWindows);
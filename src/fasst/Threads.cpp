@@ -0,0 +1,60 @@
+#include "Threads.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace fasst {
+#if defined(__linux__) && defined(_OPENMP)
+// The processors the process was allowed to run on before any thread was
+// pinned. They are kept so that forked processes still know all of them.
+static const vector<int> &processors() {
+  static vector<int> cpus;
+  if (cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &set)) {
+          cpus.push_back(c);
+        }
+      }
+    }
+  }
+  return cpus;
+}
+
+void pinThreads(int part, int parts) {
+  const char *pin = getenv("FASST_PIN_THREADS");
+  if (pin == 0 || strcmp(pin, "1") != 0 ||
+      omp_get_proc_bind() != omp_proc_bind_false) {
+    return;
+  }
+  const vector<int> &cpus = processors();
+  int C = cpus.size();
+  if (C == 0) {
+    return;
+  }
+  int first = std::min(part * C / parts, C - 1);
+  int count = std::max(1, (part + 1) * C / parts - first);
+
+#pragma omp parallel
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[first + omp_get_thread_num() % count], &set);
+    sched_setaffinity(0, sizeof(set), &set);
+  }
+}
+#else
+void pinThreads(int, int) {}
+#endif
+}
@@ -0,0 +1,25 @@
+#ifndef FASST_THREADS_H
+#define FASST_THREADS_H
+
+namespace fasst {
+
+/*!
+ This function pins each OpenMP thread to one processor, the \f$t\f$-th thread
+ to the \f$t\f$-th processor the process was allowed to run on. As the parallel
+ loops over the time frames all split the frames the same way, each thread then
+ works on the same frames, in the same memory node, from one iteration to the
+ next. Processes which share the processors, such as ShardedGEM workers, each
+ pin their threads to their own part of them.
+
+ As processes which don't know each other would all pin their threads to the
+ first processors, pinning is only done when the `FASST_PIN_THREADS`
+ environment variable is set to 1. The standard `OMP_PROC_BIND` and
+ `OMP_PLACES` environment variables are the preferred way to bind the threads:
+ nothing is done if they are already bound, or on platforms other than Linux.
+ \param part the index of the part of the processors to be used
+ \param parts the number of parts the processors are split into
+ */
+void pinThreads(int part = 0, int parts = 1);
+}
+
+#endif
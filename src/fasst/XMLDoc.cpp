@@ -1,5 +1,6 @@
 #include "XMLDoc.h"
 #include "Sources.h"
+#include "Profiler.h"
 #include <QtCore/QFile>
 #include <QtCore/QTextStream>
 #include <sstream>
@@ -9,6 +10,8 @@ using namespace std;
 
 namespace fasst {
 XMLDoc::XMLDoc(const char *fname) {
+  ScopedTimer timer("xml_read");
+
   // Open fname
   QFile file(fname);
   if (!file.open(QIODevice::ReadOnly)) {
@@ -29,6 +32,16 @@ XMLDoc::XMLDoc(const char *fname) {
   file.close();
 }
 
+XMLDoc XMLDoc::fromString(const std::string &content) {
+  // Parse XML
+  XMLDoc doc;
+  if (!doc.m_doc.setContent(QString::fromStdString(content))) {
+    throw runtime_error("Can not set content from string. "
+                        "String is probably not well-formed XML.");
+  }
+  return doc;
+}
+
 int XMLDoc::getIterations() const {
   if (m_doc.elementsByTagName("iterations").isEmpty()) {
     return 0;
@@ -38,6 +51,15 @@ int XMLDoc::getIterations() const {
   }
 }
 
+int XMLDoc::getMiniBatchFrames() const {
+  if (m_doc.elementsByTagName("minibatch_frames").isEmpty()) {
+    return 0;
+  } else {
+    return m_doc.elementsByTagName("minibatch_frames").item(0).toElement()
+        .text().toInt();
+  }
+}
+
 std::string XMLDoc::getTFRType() const {
   if (m_doc.elementsByTagName("tfr_type").isEmpty()) {
     return "STFT";
@@ -70,6 +92,8 @@ void XMLDoc::replaceSources(Sources &sources) {
 }
 
 void XMLDoc::write(const char *fname) const {
+  ScopedTimer timer("xml_write");
+
   // Open fname
   QFile file(fname);
   if (!file.open(QIODevice::WriteOnly)) {
@@ -84,4 +108,6 @@ void XMLDoc::write(const char *fname) const {
   stream << m_doc.toString();
   file.close();
 }
+
+std::string XMLDoc::toString() const { return m_doc.toString().toStdString(); }
 }
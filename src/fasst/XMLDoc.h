@@ -19,11 +19,25 @@ public:
    */
   XMLDoc(const char *fname);
 
+  /*!
+   This method parses XML data held in memory. Please note that if the data is
+   not well-formed XML, the method will throw a `runtime_error` exception.
+   \param content the XML data
+   \return the parsed document
+   */
+  static XMLDoc fromString(const std::string &content);
+
   /*!
    \return the number of iterations, or 0 if the field doesn't exist
    */
   int getIterations() const;
 
+  /*!
+   \return the number of time frames of the blocks visited by each iteration
+   of the mini-batch GEM algorithm, or 0 if the field doesn't exist
+   */
+  int getMiniBatchFrames() const;
+
   /*!
    \return the window length in the DOM
    */
@@ -57,7 +71,14 @@ public:
    */
   void write(const char *fname) const;
 
+  /*!
+   \return the current DOM as XML data
+   */
+  std::string toString() const;
+
 private:
+  XMLDoc() {}
+
   /*!
    This variable contains the whole DOM
    */
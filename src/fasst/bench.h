@@ -0,0 +1,143 @@
+#ifndef FASST_BENCH_H
+#define FASST_BENCH_H
+
+#include "Audio.h"
+#include "MixCovMatrix.h"
+#include "Sources.h"
+#include "TFRepr.h"
+#include <QDomDocument>
+#include <sstream>
+#include <string>
+
+/*!
+ \file bench.h
+ The inputs shared by the microbenchmarks. They are pseudo-random, but the same
+ from one run to the next, so that runs can be compared.
+ */
+
+namespace fasst {
+
+/*!
+ \return a pseudo-random value in [0.1, 1.1), the sequence being given by seed
+ */
+inline double benchRandom(unsigned &seed) {
+  seed = seed * 1103515245u + 12345u;
+  return 0.1 + ((seed >> 8) & 0xffff) / 65536.;
+}
+
+/*!
+ \return the XML element of a nonnegative matrix
+ \param tag the name of the element, _eg._ `Wex`
+ \param rows the number of rows
+ \param cols the number of columns
+ \param adaptability `free` or `fixed`
+ */
+inline std::string benchNonNegMatrix(const std::string &tag, int rows,
+                                     int cols,
+                                     const std::string &adaptability) {
+  unsigned seed = rows * 31 + cols;
+  std::stringstream s;
+  s << '<' << tag << " adaptability=\"" << adaptability << "\">";
+  s << "<rows>" << rows << "</rows><cols>" << cols << "</cols><data>";
+  for (int i = 0; i < cols; i++) {
+    for (int j = 0; j < rows; j++) {
+      s << benchRandom(seed) << ' ';
+    }
+    s << '\n';
+  }
+  s << "</data></" << tag << '>';
+  return s.str();
+}
+
+/*!
+ \return the XML description of a source of rank 1, whose spectral power is
+ an NMF of rank K
+ \param I the number of channels
+ \param K the NMF rank
+ \param F the number of frequency bins
+ \param N the number of time frames
+ \param conv true for convolutive mixing parameters
+ \param j the index of the source, which makes its mixing parameters differ
+ */
+inline std::string benchSource(int I, int K, int F, int N, bool conv, int j) {
+  unsigned seed = j + 1;
+  std::stringstream s;
+  s << "<source><A adaptability=\"free\" mixing_type=\""
+    << (conv ? "conv" : "inst") << "\">";
+  s << "<ndims>" << (conv ? 3 : 2) << "</ndims><dim>" << I
+    << "</dim><dim>1</dim>";
+  if (conv) {
+    s << "<dim>" << F << "</dim>";
+  }
+  s << "<type>real</type><data>";
+  for (int k = 0; k < I * (conv ? F : 1); k++) {
+    s << benchRandom(seed) << ' ';
+  }
+  s << "</data></A>";
+  s << benchNonNegMatrix("Wex", F, K, "free");
+  s << benchNonNegMatrix("Uex", K, K, "fixed");
+  s << benchNonNegMatrix("Gex", K, K, "free");
+  s << benchNonNegMatrix("Hex", K, N, "free");
+  s << "</source>";
+  return s.str();
+}
+
+/*!
+ \return J sources of rank 1
+ \param I the number of channels
+ \param J the number of sources
+ \param K the NMF rank of each source
+ \param F the number of frequency bins
+ \param N the number of time frames
+ \param conv true for convolutive mixing parameters
+ */
+inline Sources benchSources(int I, int J, int K, int F, int N, bool conv) {
+  std::string str = "<sources>";
+  for (int j = 0; j < J; j++) {
+    str += benchSource(I, K, F, N, conv, j);
+  }
+  str += "</sources>";
+  QDomDocument doc;
+  doc.setContent(QString::fromStdString(str));
+  return Sources(doc.elementsByTagName("source"));
+}
+
+/*!
+ \return an audio signal sampled at 16 kHz
+ \param samples the number of samples
+ \param channels the number of channels
+ */
+inline Audio benchAudio(int samples, int channels) {
+  unsigned seed = 1;
+  Eigen::ArrayXXd x(samples, channels);
+  for (int n = 0; n < samples; n++) {
+    for (int i = 0; i < channels; i++) {
+      x(n, i) = benchRandom(seed) - 0.6;
+    }
+  }
+  return Audio(x, 16000);
+}
+
+/*!
+ \return the STFT of a signal
+ \param I the number of channels
+ \param F the number of frequency bins
+ \param N the number of time frames
+ */
+inline TFRepr benchTFRepr(int I, int F, int N) {
+  unsigned seed = 1;
+  TFRepr X(F, N);
+  for (int f = 0; f < F; f++) {
+    for (int n = 0; n < N; n++) {
+      X(f, n) = Eigen::VectorXcd(I);
+      for (int i = 0; i < I; i++) {
+        X(f, n)(i) = std::complex<double>(benchRandom(seed) - 0.6,
+                                          benchRandom(seed) - 0.6);
+      }
+    }
+  }
+  return X;
+}
+}
+
+#endif
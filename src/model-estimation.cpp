@@ -1,26 +1,129 @@
 #include "fasst/XMLDoc.h"
 #include "fasst/Sources.h"
 #include "fasst/MixCovMatrix.h"
-#include "fasst/NaturalStatistics.h"
+#include "fasst/GEM.h"
+#include "fasst/OnlineGEM.h"
+#include "fasst/MiniBatchGEM.h"
+#include "fasst/Batch.h"
+#include "fasst/Threads.h"
+#ifndef _WIN32
+#include "fasst/ShardedGEM.h"
+#endif
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 using namespace std;
 using namespace Eigen;
 
-int main(int argc, char *argv[]) {
-  // Read command line args
-  if (argc != 4) {
-    cout << "Usage:\t" << argv[0]
-         << " input-xml-file input-bin-file output-xml-file\n";
-    return 1;
+// Estimates the sources block of frames by block of frames, without loading
+// the whole hatRx
+static int runOnline(const vector<string> &args, fasst::XMLDoc &doc,
+                     fasst::Sources &sources, int iterations, bool verbose) {
+  int blockFrames = atoi(args[3].c_str());
+  double forgetting = args.size() == 5 ? atof(args[4].c_str()) : 1.;
+  if (blockFrames <= 0 || forgetting < 0 || forgetting > 1) {
+    throw runtime_error("Error:\tblock-frames must be positive and "
+                        "forgetting-factor between 0 and 1.");
+  }
+
+  fasst::MixCovMatrixReader reader(args[1].c_str());
+  if (reader.bins() != sources.bins() ||
+      reader.channels() != sources.channels()) {
+    stringstream s;
+    s << "Error:\tdimensions are not consistent:\n";
+    s << "F = " << reader.bins() << ", I = " << reader.channels() << " in "
+      << args[1] << '\n';
+    s << "F = " << sources.bins() << ", I = " << sources.channels() << " in "
+      << args[0] << '\n';
+    throw runtime_error(s.str());
+  }
+
+  // Main loop, the activations only span the current block
+  fasst::OnlineGEM online(sources, iterations, forgetting);
+  while (reader.remaining() > 0) {
+    int first = reader.frames() - reader.remaining();
+    fasst::MixCovMatrix hatRx(reader, blockFrames);
+    double log_like = online.next(hatRx);
+    if (verbose) {
+      cout << "Block " << online.blocks() << "\tFrames " << first + 1 << " to "
+           << first + hatRx.frames() << " of " << reader.frames() << '\t';
+      cout << "Log-likelihood: " << log_like << '\n';
+    }
+  }
+
+  // Save sources
+  fasst::XMLDoc new_doc(doc);
+  new_doc.replaceSources(sources);
+  new_doc.write(args[2].c_str());
+
+  return 0;
+}
+
+#ifndef _WIN32
+// Estimates the sources with the bins split over worker processes, each of
+// them only loading its own bins of hatRx
+static int runSharded(const vector<string> &args, int shards) {
+  if (args.size() != 3) {
+    throw runtime_error("Error:\twrong number of arguments.");
   }
 
   // Load sources
-  fasst::XMLDoc doc(argv[1]);
+  fasst::XMLDoc doc(args[0].c_str());
   fasst::Sources sources = doc.getSources();
 
+  // Define number of iterations
+  int iterations = doc.getIterations();
+  if (iterations == 0) {
+    iterations = 50;
+  }
+
+  // Main loop
+  fasst::ShardedGEM gem(sources, args[1].c_str(), iterations, shards);
+  double log_like_prev = 0;
+  for (int iter = 0; iter < iterations; iter++) {
+    cout << "GEM iteration " << iter + 1 << " of " << iterations << '\t';
+    double log_like = gem.next();
+    if (iter == 0)
+      cout << "Log-likelihood: " << log_like << '\n';
+    else {
+      cout << "Log-likelihood: " << log_like << '\t';
+      cout << "Improvement: " << log_like - log_like_prev << '\n';
+    }
+    log_like_prev = log_like;
+  }
+
+  // Save sources
+  fasst::XMLDoc new_doc(doc);
+  new_doc.replaceSources(sources);
+  new_doc.write(args[2].c_str());
+
+  return 0;
+}
+#endif
+
+static int run(const vector<string> &args, bool verbose) {
+  if (args.size() < 3 || args.size() > 5) {
+    throw runtime_error("Error:\twrong number of arguments.");
+  }
+
+  // Load sources
+  fasst::XMLDoc doc(args[0].c_str());
+  fasst::Sources sources = doc.getSources();
+
+  // Define number of iterations
+  int iterations = doc.getIterations();
+  if (iterations == 0) {
+    iterations = 50;
+  }
+
+  if (args.size() > 3) {
+    return runOnline(args, doc, sources, iterations, verbose);
+  }
+
   // Load hatRx
-  fasst::MixCovMatrix hatRx(argv[2]);
+  fasst::MixCovMatrix hatRx(args[1].c_str());
   int F = hatRx.bins();
   int N = hatRx.frames();
   int I = hatRx.channels();
@@ -28,73 +131,114 @@ int main(int argc, char *argv[]) {
   // Check if dimensions are consistent
   if (F != sources.bins()) {
     cout << "Error:\tnumber of bins is not consistent:\n";
-    cout << "F = " << F << " in " << argv[2] << '\n';
-    cout << "F = " << sources.bins() << " in " << argv[1] << '\n';
+    cout << "F = " << F << " in " << args[1].c_str() << '\n';
+    cout << "F = " << sources.bins() << " in " << args[0].c_str() << '\n';
     return 1;
   }
   if (N != sources.frames()) {
     cout << "Error:\tnumber of frames is not consistent:\n";
-    cout << "N = " << N << " in " << argv[2] << '\n';
-    cout << "N = " << sources.frames() << " in " << argv[1] << '\n';
+    cout << "N = " << N << " in " << args[1].c_str() << '\n';
+    cout << "N = " << sources.frames() << " in " << args[0].c_str() << '\n';
     return 1;
   }
   if (I != sources.channels()) {
     cout << "Error:\tnumber of channels is not consistent:\n";
-    cout << "I = " << I << " in " << argv[2] << '\n';
-    cout << "I = " << sources.channels() << " in " << argv[1] << '\n';
+    cout << "I = " << I << " in " << args[1].c_str() << '\n';
+    cout << "I = " << sources.channels() << " in " << args[0].c_str() << '\n';
     return 1;
   }
 
-  // Compute additive noise
-  VectorXd noise = VectorXd::Zero(F);
-  for (int f = 0; f < F; f++) {
-    for (int n = 0; n < N; n++) {
-      noise(f) += (hatRx(f, n).real().trace() / I);
+  // With mini-batches, each iteration but the last one only visits a block
+  // of frames, so the log-likelihoods are not comparable
+  int miniBatchFrames = doc.getMiniBatchFrames();
+  if (miniBatchFrames > 0 && miniBatchFrames < N) {
+    fasst::MiniBatchGEM gem(sources, hatRx, iterations, miniBatchFrames);
+    for (int iter = 0; iter < iterations; iter++) {
+      double log_like = gem.next();
+      if (verbose) {
+        cout << "GEM iteration " << iter + 1 << " of " << iterations << '\t';
+        cout << (iter == iterations - 1 ? "Log-likelihood: "
+                                        : "Block log-likelihood: ")
+             << log_like << '\n';
+      }
     }
-    noise(f) /= N;
-  }
-  VectorXd noise_beg = noise / 100;
-  VectorXd noise_end = noise / 10000;
+  } else {
+    // Main loop
+    fasst::GEM gem(sources, hatRx, iterations);
+    double log_like_prev = 0;
+    for (int iter = 0; iter < iterations; iter++) {
+      if (verbose) {
+        cout << "GEM iteration " << iter + 1 << " of " << iterations << '\t';
+      }
 
-  // Define number of iterations
-  int iterations = doc.getIterations();
-  if (iterations == 0) {
-    iterations = 50;
+      // E-step, log-likelihood and M-step
+      double log_like = gem.next();
+      if (!verbose) {
+        continue;
+      }
+      if (iter == 0)
+        cout << "Log-likelihood: " << log_like << '\n';
+      else {
+        cout << "Log-likelihood: " << log_like << '\t';
+        cout << "Improvement: " << log_like - log_like_prev << '\n';
+      }
+      log_like_prev = log_like;
+    }
   }
 
-  // Main loop
-  double log_like_prev = 0;
-  for (int iter = 0; iter < iterations; iter++) {
-    cout << "GEM iteration " << iter + 1 << " of " << iterations << '\t';
+  // Save sources
+  fasst::XMLDoc new_doc(doc);
+  new_doc.replaceSources(sources);
+  new_doc.write(args[2].c_str());
 
-    // Compute Sigma_b
-    VectorMatrixXcd Sigma_b(F);
-    for (int f = 0; f < F; f++) {
-      double sigma_f = (sqrt(noise_beg(f)) * (iterations - iter - 1) +
-                        sqrt(noise_end(f)) * (iter + 1)) / iterations;
-      Sigma_b(f) = MatrixXcd::Identity(I, I) * sigma_f * sigma_f;
-    }
+  return 0;
+}
 
-    // Conditional expectation of the natural statistics and log-likelihood
-    fasst::NaturalStatistics stats(sources, hatRx, Sigma_b);
-    double log_like = stats.logLikelihood();
-    if (iter == 0)
-      cout << "Log-likelihood: " << log_like << '\n';
-    else {
-      cout << "Log-likelihood: " << log_like << '\t';
-      cout << "Improvement: " << log_like - log_like_prev << '\n';
+int main(int argc, char *argv[]) {
+#ifndef _WIN32
+  // Split the bins over worker processes. They are forked before any OpenMP
+  // parallel region, so the threads are only pinned by each worker, if
+  // FASST_PIN_THREADS is set.
+  if (argc == 6 && string(argv[1]) == "--shards") {
+    int shards = atoi(argv[2]);
+    if (shards <= 0) {
+      cout << "Error:\tthe number of shards must be positive.\n";
+      return 1;
     }
-    log_like_prev = log_like;
+    return runSharded(vector<string>(argv + 3, argv + argc), shards);
+  }
+#endif
 
-    // Update A
-    sources.updateMixingParameter(stats);
+  // Keep each thread on the same frames and processor across the iterations,
+  // if FASST_PIN_THREADS is set
+  fasst::pinThreads();
 
-    // Update V
-    sources.updateSpectralPower(stats);
+  // Run every line of a manifest
+  if (argc == 3 && string(argv[1]) == "--batch") {
+    fasst::Batch batch(argv[2]);
+    return batch.run(&run, 1) == 0 ? 0 : 1;
   }
 
-  // Save sources
-  fasst::XMLDoc new_doc(doc);
-  new_doc.replaceSources(sources);
-  new_doc.write(argv[3]);
+  // Read command line args
+  if (argc < 4 || argc > 6) {
+    cout << "Usage:\t" << argv[0]
+         << " input-xml-file input-bin-file output-xml-file "
+            "[block-frames [forgetting-factor]]\n";
+    cout << "\t" << argv[0] << " --batch manifest-file\n";
+    cout << "\teach line of manifest-file holds the arguments of one run\n";
+    cout << "\t" << argv[0]
+         << " --shards K input-xml-file input-bin-file output-xml-file\n";
+    cout << "\twith block-frames, the sources are estimated online on blocks "
+            "of frames, the activations only spanning the last block, and "
+            "the statistics of the previous blocks are weighted by "
+            "forgetting-factor (1 by default)\n";
+    cout << "\twith --shards, the bins are split over K worker processes\n";
+    cout << "\tset FASST_PROFILE to a file name, or - for the standard "
+            "error, to write the time spent in each stage as JSON\n";
+    cout << "\tset FASST_PIN_THREADS to 1 to pin each thread to a processor, "
+            "or rather bind them with OMP_PROC_BIND and OMP_PLACES\n";
+    return 1;
+  }
+
+  return run(vector<string>(argv + 1, argv + argc), true);
 }
@@ -0,0 +1,165 @@
+#include "fasst/Audio.h"
+#include "fasst/GEM.h"
+#include "fasst/MixCovMatrix.h"
+#include "fasst/Sources.h"
+#include "fasst/XMLDoc.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <stdexcept>
+
+// Audio and MixCovMatrix derive from Eigen arrays, so the Eigen type casters of
+// pybind11 are not used: arrays go through the NumPy buffers below.
+
+namespace py = pybind11;
+using namespace std;
+using namespace Eigen;
+
+typedef py::array_t<double, py::array::f_style | py::array::forcecast>
+    AudioArray;
+
+/*!
+ Copies a samples-by-channels NumPy array to an Audio object, which owns its
+ samples. Fortran-ordered arrays of doubles are copied once, other arrays are
+ converted first. The samplerate is needed by the ERB transforms.
+ */
+static fasst::Audio toAudio(const AudioArray &a, int samplerate) {
+  if (a.ndim() != 2) {
+    throw runtime_error("Error:\taudio arrays must be samples-by-channels.");
+  }
+  return fasst::Audio(Map<const ArrayXXd>(a.data(), a.shape(0), a.shape(1)),
+                      samplerate);
+}
+
+static void deleteAudio(void *x) { delete static_cast<fasst::Audio *>(x); }
+
+/*!
+ Gives an Audio object allocated on the heap to a NumPy array, which views its
+ samples without copying them and deletes it when it is garbage collected.
+ */
+static py::array fromAudio(fasst::Audio *x) {
+  py::capsule owner(x, &deleteAudio);
+  return AudioArray({x->rows(), x->cols()},
+                    {sizeof(double), sizeof(double) * x->rows()}, x->data(),
+                    owner);
+}
+
+static py::tuple readAudio(const string &fname) {
+  fasst::Audio *x = new fasst::Audio(fname.c_str());
+  int samplerate = x->samplerate();
+  return py::make_tuple(fromAudio(x), samplerate);
+}
+
+static void writeAudio(const string &fname, const AudioArray &a,
+                       int samplerate, const string &format) {
+  fasst::Audio x = toAudio(a, samplerate);
+  x.write(fname, samplerate, format);
+}
+
+static fasst::MixCovMatrix *computeMixCovMatrix(const AudioArray &a,
+                                                int samplerate,
+                                                const string &tfr_type,
+                                                int wlen, int nbin) {
+  return new fasst::MixCovMatrix(toAudio(a, samplerate), tfr_type, wlen, nbin);
+}
+
+/*!
+ Wiener filters a mixture with sources which may have been estimated in this
+ process: GEM only updates their global mixing parameter, so it is copied to
+ each source first.
+ */
+static py::list filterSources(fasst::Sources &sources, const AudioArray &a,
+                              int samplerate, const string &tfr_type,
+                              int wlen) {
+  sources.syncMixingParameter();
+  vector<fasst::Audio> output =
+      sources.Filter(toAudio(a, samplerate), tfr_type, wlen);
+  py::list list;
+  for (size_t j = 0; j < output.size(); j++) {
+    list.append(fromAudio(new fasst::Audio(std::move(output[j]))));
+  }
+  return list;
+}
+
+/*!
+ Gives a read-only view of the spectral power of a source, which keeps the
+ sources alive.
+ */
+static py::array sourceV(py::object self, int j) {
+  const fasst::Sources &sources = self.cast<const fasst::Sources &>();
+  if (j < 0 || j >= sources.size()) {
+    throw py::index_error("source index out of range");
+  }
+  const ArrayXXd &V = sources[j].V();
+  py::array_t<double> view({V.rows(), V.cols()},
+                           {sizeof(double), sizeof(double) * V.rows()},
+                           V.data(), self);
+  view.attr("setflags")(py::arg("write") = false);
+  return view;
+}
+
+static string sourceName(const fasst::Sources &sources, int j) {
+  if (j < 0 || j >= sources.size()) {
+    throw py::index_error("source index out of range");
+  }
+  return sources[j].name();
+}
+
+PYBIND11_MODULE(_fasst, m) {
+  m.doc() = "Native interface to the FASST library";
+
+  m.def("read_audio", &readAudio, py::arg("fname"),
+        "Reads an audio file, returns a samples-by-channels array and the "
+        "samplerate");
+  m.def("write_audio", &writeAudio, py::arg("fname"), py::arg("x"),
+        py::arg("samplerate"), py::arg("format") = "pcm16",
+        "Writes a samples-by-channels array to an audio file");
+
+  py::class_<fasst::MixCovMatrix>(m, "MixCovMatrix")
+      .def(py::init<const char *>(), py::arg("fname"))
+      .def_static("compute", &computeMixCovMatrix, py::arg("x"),
+                  py::arg("samplerate"), py::arg("tfr_type"),
+                  py::arg("wlen"), py::arg("nbin") = 0,
+                  "Computes the mixture covariance matrices of a "
+                  "samples-by-channels array")
+      .def("bins", &fasst::MixCovMatrix::bins)
+      .def("frames", &fasst::MixCovMatrix::frames)
+      .def("channels", &fasst::MixCovMatrix::channels)
+      .def("write", &fasst::MixCovMatrix::write, py::arg("fname"));
+
+  py::class_<fasst::Sources>(m, "Sources")
+      .def("size", &fasst::Sources::size)
+      .def("bins", &fasst::Sources::bins)
+      .def("frames", &fasst::Sources::frames)
+      .def("channels", &fasst::Sources::channels)
+      .def("name", &sourceName, py::arg("j"))
+      .def("V", &sourceV, py::arg("j"),
+           "Read-only F-by-N view of the spectral power of a source")
+      .def("filter", &filterSources, py::arg("x"), py::arg("samplerate"),
+           py::arg("tfr_type"), py::arg("wlen"),
+           "Wiener filters a samples-by-channels mixture, returns one array "
+           "per source");
+
+  py::class_<fasst::XMLDoc>(m, "XMLDoc")
+      .def(py::init<const char *>(), py::arg("fname"))
+      .def_static("from_string", &fasst::XMLDoc::fromString,
+                  py::arg("content"))
+      .def("iterations", &fasst::XMLDoc::getIterations)
+      .def("tfr_type", &fasst::XMLDoc::getTFRType)
+      .def("wlen", &fasst::XMLDoc::getWlen)
+      .def("nbin", &fasst::XMLDoc::getNbin)
+      .def("sources", &fasst::XMLDoc::getSources)
+      .def("replace_sources", &fasst::XMLDoc::replaceSources,
+           py::arg("sources"))
+      .def("to_string", &fasst::XMLDoc::toString)
+      .def("write", &fasst::XMLDoc::write, py::arg("fname"));
+
+  // GEM holds references to the sources and to Rx, which are kept alive
+  py::class_<fasst::GEM>(m, "GEM")
+      .def(py::init<fasst::Sources &, const fasst::MixCovMatrix &, int>(),
+           py::arg("sources"), py::arg("Rx"), py::arg("iterations"),
+           py::keep_alive<1, 2>(), py::keep_alive<1, 3>())
+      .def("next", &fasst::GEM::next,
+           "Runs the next iteration, returns the log-likelihood")
+      .def("iteration", &fasst::GEM::iteration)
+      .def("iterations", &fasst::GEM::iterations);
+}
@@ -0,0 +1,117 @@
+"""
+Tests of the _fasst extension.
+
+Usage: python fasst_module_test.py module-dir data-dir
+"""
+
+from __future__ import division, print_function
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+
+import numpy as np
+
+MODULE_DIR = sys.argv[1]
+DATA_DIR = sys.argv[2]
+sys.path.insert(0, MODULE_DIR)
+import _fasst
+
+MIXTURE = os.path.join(DATA_DIR, 'Shannon_Hurley__Sunrise__inst__mix.wav')
+
+
+def matrix_xml(tag, data, adaptability):
+    rows, cols = data.shape
+    return ('<%s adaptability="%s"><rows>%d</rows><cols>%d</cols><data>%s'
+            '</data></%s>' % (tag, adaptability, rows, cols,
+                              ' '.join(str(e) for e in data.T.flat), tag))
+
+
+def model_xml(tfr_type, wlen, nbin, Rx, J, K=4):
+    """Returns a model of J instantaneous rank-1 sources with random NMF
+    parameters, sized for Rx"""
+    random = np.random.RandomState(0)
+    I, F, N = Rx.channels(), Rx.bins(), Rx.frames()
+    s = '<sources><tfr_type>%s</tfr_type><wlen>%d</wlen><nbin>%d</nbin>' % (
+        tfr_type, wlen, nbin)
+    for j in range(J):
+        s += '<source name="s%d">' % j
+        s += ('<A adaptability="free" mixing_type="inst"><ndims>2</ndims>'
+              '<dim>%d</dim><dim>1</dim><type>real</type><data>%s</data>'
+              '</A>' % (I, ' '.join(str(e) for e in random.rand(I))))
+        s += matrix_xml('Wex', 0.5 + random.rand(F, K), 'free')
+        s += matrix_xml('Uex', np.eye(K), 'fixed')
+        s += matrix_xml('Gex', np.eye(K), 'fixed')
+        s += matrix_xml('Hex', 0.5 + random.rand(K, N), 'free')
+        s += '</source>'
+    return s + '</sources>'
+
+
+class ExtensionTest(unittest.TestCase):
+    def setUp(self):
+        self.x, self.samplerate = _fasst.read_audio(MIXTURE)
+        self.x = self.x[:16384]
+        self.dirname = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dirname)
+
+    def estimate(self, tfr_type, wlen, nbin, iterations):
+        Rx = _fasst.MixCovMatrix.compute(self.x, self.samplerate, tfr_type,
+                                         wlen, nbin)
+        doc = _fasst.XMLDoc.from_string(model_xml(tfr_type, wlen, nbin, Rx,
+                                                  3))
+        sources = doc.sources()
+        gem = _fasst.GEM(sources, Rx, iterations)
+        for iteration in range(iterations):
+            self.assertTrue(np.isfinite(gem.next()))
+        return doc, sources
+
+    def test_audio(self):
+        fname = os.path.join(self.dirname, 'x.wav')
+        _fasst.write_audio(fname, self.x, self.samplerate, 'float')
+        y, samplerate = _fasst.read_audio(fname)
+        self.assertEqual(self.samplerate, samplerate)
+        self.assertEqual(self.x.shape, y.shape)
+        self.assertLess(np.abs(self.x - y).max(), 1e-6)
+
+    def test_filter(self):
+        doc, sources = self.estimate('STFT', 1024, 0, 5)
+        y = sources.filter(self.x, self.samplerate, 'STFT', 1024)
+        self.assertEqual(3, len(y))
+        for j in range(3):
+            self.assertEqual(self.x.shape, y[j].shape)
+
+        # Filtering again doesn't smooth the spectral powers again
+        y_again = sources.filter(self.x, self.samplerate, 'STFT', 1024)
+        for j in range(3):
+            self.assertTrue((y[j] == y_again[j]).all())
+
+        # The estimated parameters written to XML give the same sources, to
+        # the 6 significant digits kept by the XML document
+        doc.replace_sources(sources)
+        reloaded = _fasst.XMLDoc.from_string(doc.to_string()).sources()
+        y_ref = reloaded.filter(self.x, self.samplerate, 'STFT', 1024)
+        for j in range(3):
+            self.assertLess(np.abs(y[j] - y_ref[j]).max(),
+                            1e-3 * np.abs(y_ref[j]).max())
+
+    def test_erb(self):
+        # The ERB transforms read the samplerate, and the estimates have as
+        # many channels as the rank of the sources
+        doc, sources = self.estimate('ERB', 1024, 32, 2)
+        y = sources.filter(self.x, self.samplerate, 'ERB', 1024)
+        for j in range(3):
+            self.assertEqual((self.x.shape[0], 1), y[j].shape)
+            self.assertTrue(np.isfinite(y[j]).all())
+
+    def test_spectral_power(self):
+        doc, sources = self.estimate('STFT', 1024, 0, 1)
+        V = sources.V(0)
+        self.assertEqual((sources.bins(), sources.frames()), V.shape)
+        self.assertFalse(V.flags.writeable)
+
+
+if __name__ == '__main__':
+    unittest.main(argv=sys.argv[:1])
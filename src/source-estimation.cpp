@@ -2,42 +2,66 @@
 #include "fasst/XMLDoc.h"
 #include "fasst/TFRepr.h"
 #include "fasst/Sources.h"
+#include "fasst/SourceSink.h"
+#include "fasst/Batch.h"
 #include <Eigen/Dense>
 #include <iostream>
+#include <cstdlib>
+#include <stdexcept>
 
 using namespace std;
 using namespace Eigen;
 
-int main(int argc, char *argv[]) {
-  // Read command line args
-  if (argc != 4) {
-    cout << "Usage:\t" << argv[0] << " input-wav-file input-xml-file output-wav-dir\n";
-    return 1;
+// Reads the input audio, whose format is given for headerless input
+static fasst::Audio readAudio(const vector<string> &args) {
+  if (args.size() == 6) {
+    fasst::AudioReader reader(args[0].c_str(), atoi(args[4].c_str()),
+                              atoi(args[5].c_str()));
+    return fasst::Audio(reader);
+  }
+  fasst::AudioReader reader(args[0].c_str());
+  return fasst::Audio(reader);
+}
+
+static int run(const vector<string> &args, bool) {
+  if (args.size() != 3 && args.size() != 4 && args.size() != 6) {
+    throw runtime_error("Error:\twrong number of arguments.");
   }
 
   // Read audio
-  fasst::Audio x(argv[1]);
+  fasst::Audio x = readAudio(args);
 
   // Read wlen and TFR type from XML
-  fasst::XMLDoc doc(argv[2]);
+  fasst::XMLDoc doc(args[1].c_str());
   std::string tfr_type = doc.getTFRType();
   int wlen = doc.getWlen();
   
   // Read output dirname
-  string dirname = argv[3];
+  string dirname = args[2];
+  bool toStdout = dirname == "-";
   if (dirname[dirname.length()-1] != '/') {
       dirname.push_back('/');
   }
 
+  // Read output format
+  string format = toStdout ? "raw" : "pcm16";
+  if (args.size() >= 4) {
+    format = args[3];
+  }
+
   // Load sources
   fasst::Sources sources = doc.getSources();
   int J = sources.size();
 
-  // Wiener filter
-  vector<fasst::Audio> output =  sources.Filter(x, tfr_type, wlen);
-
+  // Wiener filter, the sources are multiplexed to the standard output
+  if (toStdout) {
+    fasst::SourceMultiplexer writer("-", x.samplerate(), format);
+    sources.Filter(x, tfr_type, wlen, writer);
+    return 0;
+  }
 
-  // Write audio file
+  // Output file names
+  vector<string> fnames(J);
   for (int j = 0; j < J; j++) {
     string srcname;
     if (sources[j].name().empty()) {
@@ -47,6 +71,39 @@ int main(int argc, char *argv[]) {
     } else {
       srcname = sources[j].name();
     }
-    output[j].write(dirname + srcname + ".wav", x.samplerate());
+    fnames[j] = dirname + srcname + fasst::AudioWriter::extension(format);
   }
+
+  // Wiener filter, the source signals are written block by block
+  fasst::SourceWriter writer(fnames, x.samplerate(), format);
+  sources.Filter(x, tfr_type, wlen, writer);
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  // Run every line of a manifest
+  if (argc == 3 && string(argv[1]) == "--batch") {
+    fasst::Batch batch(argv[2]);
+    return batch.run(&run, 0) == 0 ? 0 : 1;
+  }
+
+  // Read command line args
+  if (argc != 4 && argc != 5 && argc != 7) {
+    cout << "Usage:\t" << argv[0]
+         << " input-wav-file input-xml-file output-wav-dir"
+            " [output-format [input-channels input-samplerate]]\n";
+    cout << "\t" << argv[0] << " --batch manifest-file\n";
+    cout << "\toutput-format is one of pcm16 (default), pcm24, float, flac "
+            "and raw\n";
+    cout << "\tinput-wav-file - reads the standard input, output-wav-dir - "
+            "writes all the sources one after the other in each sample to "
+            "the standard output (raw by default)\n";
+    cout << "\tinput-channels and input-samplerate are given for headerless "
+            "32-bit float input\n";
+    cout << "\teach line of manifest-file holds the arguments of one run\n";
+    return 1;
+  }
+
+  return run(vector<string>(argv + 1, argv + argc), true);
 }